@@ -2,11 +2,26 @@
 #include <array>
 #include <vector>
 #include <algorithm>
+#include <filesystem>
+#include <cstdio>
+#include <thread>
 #include "fmt/format.h"
 #define CATCH_CONFIG_MAIN
 #include "catch2/catch.hpp"
 
 #include "../joyinput.h"
+#include "../ring_buffer.h"
+#include "../binlog.h"
+#include "../spsc_queue.h"
+#include "../triple_buffer.h"
+#include "../wire.h"
+#include "../rng.h"
+#include "../component_table.h"
+#include "../arena.h"
+#include "../columnar.h"
+#include "../match.h"
+#include "../sweep.h"
+#include "../telemetry.h"
 
 
 TEST_CASE("Joystick parse")
@@ -59,4 +74,533 @@ TEST_CASE("Joystick parse")
             REQUIRE(result.type == result.invalid);
         }
     }
-}
\ No newline at end of file
+}
+
+TEST_CASE("Ring buffer")
+{
+    util::ring_buffer<int, 4> rb;
+    REQUIRE(rb.empty());
+
+    rb.push(1);
+    rb.push(2);
+    REQUIRE(rb.size() == 2);
+    REQUIRE(rb.offset() == 0);
+    REQUIRE(rb[0] == 1);
+    REQUIRE(rb.back() == 2);
+
+    for (int i = 3; i <= 6; i++)
+        rb.push(i);
+
+    REQUIRE(rb.full());
+    REQUIRE(rb.size() == 4);
+    // mais antigo primeiro
+    REQUIRE(rb[0] == 3);
+    REQUIRE(rb[3] == 6);
+    REQUIRE(rb.data()[rb.offset()] == 3);
+    REQUIRE(rb.back() == 6);
+}
+
+TEST_CASE("Binary log round trip")
+{
+    auto const path = std::filesystem::temp_directory_path() / "sfpong-test.binlog";
+
+    REQUIRE(pong::binlog::start(path, false));
+    PONG_LOG_INFO("score: {}x{} ; serve: {}", 3, 2, pong::binlog::tag("left"));
+    PONG_LOG_WARN("speed {:.1f} ok={}", 12.5, true);
+    pong::binlog::stop();
+
+    std::FILE* out = std::tmpfile();
+    REQUIRE(pong::binlog::decode(path, out));
+
+    std::rewind(out);
+    char buf[256] = {};
+    std::fread(buf, 1, sizeof(buf) - 1, out);
+    std::fclose(out);
+
+    std::string text = buf;
+    CHECK(text.find("[info] score: 3x2 ; serve: left") != text.npos);
+    CHECK(text.find("[warn] speed 12.5 ok=true") != text.npos);
+}
+
+TEST_CASE("SPSC queue")
+{
+    util::spsc_queue<int, 4> q;
+    int v = 0;
+    REQUIRE(!q.pop(v));
+
+    for (int i = 0; i < 4; i++)
+        REQUIRE(q.push(i));
+    REQUIRE(!q.push(4)); // cheia
+
+    REQUIRE(q.pop(v));
+    REQUIRE(v == 0);
+    REQUIRE(q.push(4));
+
+    // ordem preservada entre threads
+    util::spsc_queue<int, 64> q2;
+    std::thread producer([&] {
+        for (int i = 0; i < 10000; i++)
+            while (!q2.push(i)) std::this_thread::yield();
+    });
+
+    int expected = 0;
+    bool inOrder = true;
+    while (expected < 10000)
+    {
+        if (q2.pop(v)) {
+            inOrder &= v == expected;
+            expected++;
+        }
+    }
+    producer.join();
+    REQUIRE(inOrder);
+}
+
+TEST_CASE("Triple buffer")
+{
+    util::triple_buffer<int> tb;
+    REQUIRE(!tb.update());
+
+    tb.write() = 1;
+    tb.publish();
+    tb.write() = 2;
+    tb.publish();
+
+    // o leitor só vê o último
+    REQUIRE(tb.update());
+    REQUIRE(tb.read() == 2);
+    REQUIRE(!tb.update());
+    REQUIRE(tb.read() == 2);
+
+    tb.write() = 3;
+    tb.publish();
+    REQUIRE(tb.update());
+    REQUIRE(tb.read() == 3);
+}
+
+TEST_CASE("Wire round trip")
+{
+    std::uint8_t buf[16];
+    util::wire_writer w(buf, sizeof(buf));
+    w.put(std::uint32_t(0x11223344)).put(-1.5f).put(std::uint8_t(7));
+    REQUIRE(w.ok());
+    REQUIRE(w.size() == 9);
+    REQUIRE(buf[0] == 0x44); // little-endian
+
+    w.put(std::uint64_t(1)); // não cabe
+    REQUIRE(!w.ok());
+    REQUIRE(w.size() == 9);
+
+    util::wire_reader r(buf, 9);
+    REQUIRE(r.get<std::uint32_t>() == 0x11223344);
+    REQUIRE(r.get<float>() == -1.5f);
+    REQUIRE(r.get<std::uint8_t>() == 7);
+    REQUIRE(r.ok());
+    r.get<std::uint8_t>();
+    REQUIRE(!r.ok());
+
+    util::wire_writer vw(buf, sizeof(buf));
+    vw.put_varint(127).put_varint(300).put_svarint(-1).put_svarint(-70000);
+    REQUIRE(vw.size() == 1 + 2 + 1 + 3);
+
+    util::wire_reader vr(buf, vw.size());
+    CHECK(vr.get_varint() == 127);
+    CHECK(vr.get_varint() == 300);
+    CHECK(vr.get_svarint() == -1);
+    CHECK(vr.get_svarint() == -70000);
+    CHECK(vr.ok());
+}
+
+TEST_CASE("Counter-based RNG")
+{
+    const auto key = pong::squares::key(42);
+    REQUIRE(key & 1);
+
+    // função pura de (contador, chave)
+    pong::rng_stream a(key, 100), b(key, 100), c(key, 101);
+    const auto first = a.next();
+    REQUIRE(first == b.next());
+    REQUIRE(first != c.next());
+
+    // bulk = sorteios um a um
+    std::uint32_t bulk[64];
+    pong::rng_stream(key, 7).fill(bulk, 64);
+    pong::rng_stream seq(key, 7);
+    bool same = true;
+    for (auto v : bulk) same &= v == seq.next();
+    REQUIRE(same);
+
+    pong::rng_stream d(key, 0);
+    int counts[6] = {};
+    bool inRange = true;
+    for (int i = 0; i < 60000; i++)
+    {
+        const auto v = d.range(1, 6);
+        inRange &= v >= 1 && v <= 6;
+        if (v >= 1 && v <= 6) counts[v - 1]++;
+    }
+    REQUIRE(inRange);
+    for (auto n : counts) CHECK(std::abs(n - 10000) < 500);
+}
+
+TEST_CASE("Component table")
+{
+    struct pos { float x; };
+    struct name { std::string value; };
+
+    util::component_table<pos, name> table;
+    REQUIRE(table.empty());
+
+    REQUIRE(table.add({ 1 }, { "a" }) == 0);
+    REQUIRE(table.add({ 2 }, { "b" }) == 1);
+    REQUIRE(table.add({ 3 }, { "c" }) == 2);
+    REQUIRE(table.size() == 3);
+    REQUIRE(table.get<pos>().size() == 3);
+
+    // colunas andam juntas
+    table.get<pos>()[1].x = 20;
+    CHECK(table.get<name>()[1].value == "b");
+
+    // remove troca com a última, nas duas colunas
+    table.remove(0);
+    REQUIRE(table.size() == 2);
+    CHECK(table.get<pos>()[0].x == 3);
+    CHECK(table.get<name>()[0].value == "c");
+    CHECK(table.get<pos>()[1].x == 20);
+
+    table.remove(1);
+    REQUIRE(table.size() == 1);
+    CHECK(table.get<name>()[0].value == "c");
+
+    table.clear();
+    CHECK(table.empty());
+    CHECK(table.get<name>().empty());
+}
+
+TEST_CASE("Rect BVH")
+{
+    using pong::rect;
+
+    // grade de blocos 10x10 com folga entre eles
+    std::vector<rect> blocks;
+    for (int y = 0; y < 30; y++)
+        for (int x = 0; x < 30; x++)
+            blocks.push_back({ x * 15.f, y * 15.f, 10, 10 });
+
+    const pong::rect_bvh bvh(blocks);
+    REQUIRE(bvh.rects().size() == blocks.size());
+    REQUIRE(bvh.depth() > 1);
+
+    // mesmo resultado que testar todos
+    pong::rng_stream dice(pong::squares::key(3), 0);
+    bool same = true;
+    for (int q = 0; q < 500; q++)
+    {
+        const rect probe = { dice.unit() * 460 - 10, dice.unit() * 460 - 10, 1 + dice.unit() * 40, 1 + dice.unit() * 40 };
+
+        int fromBvh = 0, linear = 0;
+        bvh.query(probe, [&](const rect&) { fromBvh++; });
+        for (auto& b : blocks) linear += pong::collision(b, probe);
+        same &= fromBvh == linear;
+    }
+    REQUIRE(same);
+
+    // no vão entre os blocos não encosta em nada
+    CHECK_FALSE(bvh.any({ 10.5f, 10.5f, 4, 4 }));
+    CHECK(bvh.any({ 0, 0, 1, 1 }));
+    CHECK_FALSE(pong::rect_bvh().any({ 0, 0, 100, 100 }));
+}
+
+TEST_CASE("Match snapshot")
+{
+    using namespace pong;
+    match sim(court_t::standard({ gvar::playarea_width, gvar::playarea_height }), 42);
+    sim.mute(true);
+    sim.apply({ sim_message::mode, std::uint8_t(gamemode::aitest) });
+    sim.apply({ sim_message::resume });
+
+    auto run = [&](int ticks) {
+        for (int t = 0; t < ticks; t++)
+        {
+            if (sim.waiting_to_serve())
+                sim.apply({ sim_message::serve });
+            sim.step();
+        }
+    };
+
+    run(500);
+    const auto saved = sim.state();
+    REQUIRE(hash(saved) == hash(sim.state()));
+
+    // mais N ticks, volta e refaz: mesmo estado e mesmo hash
+    run(2000);
+    const auto first = sim.state();
+    REQUIRE(first.tick == saved.tick + 2000);
+
+    sim.restore(saved);
+    CHECK(hash(sim.state()) == hash(saved));
+    run(2000);
+    const auto again = sim.state();
+
+    CHECK(hash(again) == hash(first));
+    CHECK(again.ballPos == first.ballPos);
+    CHECK(again.ballVel == first.ballVel);
+    CHECK(again.paddles[0].pos == first.paddles[0].pos);
+    CHECK(again.paddles[1].aiWait == first.paddles[1].aiWait);
+    CHECK(again.score[0] == first.score[0]);
+    CHECK(again.score[1] == first.score[1]);
+    CHECK(again.rng == first.rng);
+
+    // qualquer campo muda o hash
+    auto changed = first;
+    changed.ballPos.x += 1;
+    CHECK(hash(changed) != hash(first));
+    changed = first;
+    changed.paddles[1].ai = !changed.paddles[1].ai;
+    CHECK(hash(changed) != hash(first));
+    changed = first;
+    changed.tick++;
+    CHECK(hash(changed) != hash(first));
+    changed = first;
+    changed.input.players[0].up = !changed.input.players[0].up;
+    CHECK(hash(changed) != hash(first));
+}
+
+TEST_CASE("Columnar round trip")
+{
+    using namespace pong::columnar;
+    auto const path = std::filesystem::temp_directory_path() / "sfpong-test.col";
+
+    // 4 threads, cada uma com o seu appender; grupos cheios e um pela metade
+    constexpr std::uint32_t per_thread = group_rows + group_rows / 2;
+    {
+        writer w;
+        REQUIRE(w.open(path, { { "id", column_type::u32 }, { "tick", column_type::u64 },
+            { "delta", column_type::i32 }, { "speed", column_type::f32 } }));
+
+        std::vector<std::jthread> threads;
+        for (std::uint32_t t = 0; t < 4; t++)
+        {
+            threads.emplace_back([&w, t] {
+                auto out = w.make_appender();
+                for (std::uint32_t i = 0; i < per_thread; i++) {
+                    out.append(t * per_thread + i, std::uint64_t(i) * 600, int(i % 7) - 3, 0.5f * (i % 40));
+                }
+            });
+        }
+        threads.clear();
+        REQUIRE(w.close());
+        CHECK(w.bytes() < w.raw_bytes() / 2);
+    }
+
+    reader r;
+    REQUIRE(r.open(path));
+    REQUIRE(r.rows() == 4 * per_thread);
+    REQUIRE(r.columns().size() == 4);
+    CHECK(r.find("tick") == 1);
+    CHECK(r.find("nope") == -1);
+
+    // rodapé e scan batem
+    const auto ids = r.stats(0);
+    CHECK(ids.min == 0);
+    CHECK(ids.max == 4 * per_thread - 1);
+
+    std::vector<bool> seen(4 * per_thread);
+    REQUIRE(r.scan<std::uint32_t>(0, [&](auto v) { for (auto id : v) seen[id] = true; }));
+    CHECK(std::all_of(seen.begin(), seen.end(), [](bool b) { return b; }));
+
+    double sum = 0;
+    REQUIRE(r.scan<std::int32_t>(2, [&](auto v) { for (auto d : v) sum += d; }));
+    CHECK(sum == r.stats(2).sum);
+
+    // tick e id da mesma linha: tick = (id % per_thread) * 600
+    bool rowsMatch = true;
+    REQUIRE(r.scan<std::uint32_t, std::uint64_t>(0, 1, [&](auto id, auto tick) {
+        for (std::size_t i = 0; i < id.size(); i++) rowsMatch &= tick[i] == std::uint64_t(id[i] % per_thread) * 600;
+    }));
+    CHECK(rowsMatch);
+
+    CHECK_FALSE(r.scan<float>(0, [](auto) {}));
+    r.close();
+    std::filesystem::remove(path);
+}
+
+TEST_CASE("Columnar close right after appenders")
+{
+    using namespace pong::columnar;
+    auto const path = std::filesystem::temp_directory_path() / "sfpong-test-close.col";
+
+    // grupos pequenos entrando na fila logo antes do close(): nenhum pode
+    // ficar pra trás. Várias vezes, que a janela é curta
+    for (int round = 0; round < 50; round++)
+    {
+        constexpr std::uint32_t threadCount = 6, per_thread = 100;
+        {
+            writer w;
+            REQUIRE(w.open(path, { { "id", column_type::u32 } }));
+
+            std::vector<std::jthread> threads;
+            for (std::uint32_t t = 0; t < threadCount; t++)
+            {
+                threads.emplace_back([&w, t] {
+                    auto out = w.make_appender();
+                    for (std::uint32_t i = 0; i < per_thread; i++) {
+                        out.append(t * per_thread + i);
+                    }
+                });
+            }
+            threads.clear();
+            REQUIRE(w.close());
+        }
+
+        reader r;
+        REQUIRE(r.open(path));
+        REQUIRE(r.rows() == threadCount * per_thread);
+        CHECK(r.groups() == threadCount);
+        CHECK(r.stats(0).sum == double(threadCount * per_thread) * (threadCount * per_thread - 1) / 2);
+    }
+    std::filesystem::remove(path);
+
+    // disco cheio: close() avisa em vez de fingir que gravou
+    if (std::filesystem::exists("/dev/full"))
+    {
+        writer w;
+        REQUIRE(w.open("/dev/full", { { "id", column_type::u32 } }));
+        {
+            auto out = w.make_appender();
+            for (std::uint32_t i = 0; i < 3 * group_rows; i++) out.append(i);
+        }
+        CHECK_FALSE(w.close());
+    }
+}
+
+TEST_CASE("Sweep axes")
+{
+    pong::sweep_axis axis;
+    for (auto bad : { "", "ball.max_speed", "nope=1:2", "ball.max_speed=", "ball.max_speed=abc",
+        "ball.max_speed=30:10", "ball.max_speed=10:30:0", "ball.max_speed=10:30:5:7", "ball.max_speed=10:30:5x" })
+    {
+        CHECK_FALSE(pong::parse_sweep_axis(bad, axis));
+    }
+
+    REQUIRE(pong::parse_sweep_axis("ball.max_speed=20", axis));
+    CHECK(axis.min == 20);
+    CHECK(axis.max == 20);
+    CHECK(axis.steps == 1);
+    REQUIRE(pong::parse_sweep_axis("ball.max_speed=10:30", axis));
+    CHECK(axis.steps == 2);
+
+    // grade 3 x 2: o primeiro eixo varia mais devagar
+    pong::sweep_config cfg;
+    pong::sweep_axis speed, size;
+    REQUIRE(pong::parse_sweep_axis("ball.max_speed=10:30:3", speed));
+    REQUIRE(pong::parse_sweep_axis("paddle.height=100:200:2", size));
+    cfg.axes = { speed, size };
+
+    const auto grid = pong::sweep_points(cfg);
+    REQUIRE(grid.size() == 6);
+    const float speeds[] = { 10, 10, 20, 20, 30, 30 };
+    const float heights[] = { 100, 200, 100, 200, 100, 200 };
+    for (std::size_t i = 0; i < grid.size(); i++)
+    {
+        CHECK(grid[i].ball_max_speed == speeds[i]);
+        CHECK(grid[i].paddle_height == heights[i]);
+        CHECK(grid[i].ball_speed == cfg.base.guts.ball_speed); // fora dos eixos: base
+    }
+
+    // hipercubo latino: cada uma das n faixas de cada eixo tem um ponto só
+    cfg.latin = 16;
+    const auto latin = pong::sweep_points(cfg);
+    REQUIRE(latin.size() == 16);
+    for (auto& a : cfg.axes)
+    {
+        std::vector<int> hits(cfg.latin);
+        for (auto& p : latin)
+        {
+            const float u = (p.*a.field - a.min) / (a.max - a.min);
+            REQUIRE(u >= 0);
+            REQUIRE(u <= 1);
+            hits[std::min(int(u * cfg.latin), cfg.latin - 1)]++;
+        }
+        CHECK(std::all_of(hits.begin(), hits.end(), [](int n) { return n == 1; }));
+    }
+    CHECK(pong::sweep_points(cfg) == latin); // mesma seed, mesmos pontos
+}
+
+TEST_CASE("Physics profile")
+{
+    CHECK(pong::physics_profile().valid());
+    CHECK(pong::physics_profile().builtin());
+    CHECK(pong::physics_profile::field("ball.max_speed") == &pong::physics_profile::ball_max_speed);
+    CHECK(pong::physics_profile::field("ball.nope") == nullptr);
+
+    auto broken = pong::physics_profile();
+    broken.paddle_height = 0;
+    CHECK_FALSE(broken.valid());
+    broken = {};
+    broken.ball_acceleration = -1;
+    CHECK_FALSE(broken.valid());
+    broken.ball_acceleration = 0; // sem aceleração vale
+    CHECK(broken.valid());
+
+    auto const path = std::filesystem::temp_directory_path() / "sfpong-test-guts.info";
+    auto write = [&](const char* text) {
+        auto f = std::fopen(path.string().c_str(), "w");
+        REQUIRE(f);
+        std::fputs(text, f);
+        std::fclose(f);
+    };
+
+    // o que falta fica com o padrão
+    write("ball\n{\n    max_speed 25\n}\n");
+    auto loaded = pong::physics_profile::load(path);
+    REQUIRE(loaded);
+    CHECK(loaded->ball_max_speed == 25);
+    CHECK(loaded->paddle_width == pong::builtin_guts::paddle_width);
+    CHECK_FALSE(loaded->builtin());
+
+    write("paddle\n{\n    width -5\n}\n");
+    CHECK_FALSE(pong::physics_profile::load(path));
+    CHECK(pong::physics_profile::load_or_builtin(path).builtin());
+
+    write("ball\n{\n    speed fast\n}\n");
+    CHECK_FALSE(pong::physics_profile::load(path));
+
+    write("ball\n{\n    speed 5\n"); // sem fechar
+    CHECK_FALSE(pong::physics_profile::load(path));
+
+    std::filesystem::remove(path);
+    CHECK(pong::physics_profile::load_or_builtin(path).builtin());
+    CHECK(pong::physics_profile::load_or_builtin("").builtin());
+}
+
+TEST_CASE("Telemetry partial blocks")
+{
+    using namespace pong::telemetry;
+    using namespace std::chrono_literals;
+    auto const dir = std::filesystem::temp_directory_path() / "sfpong-test-telemetry";
+    std::filesystem::remove_all(dir);
+    REQUIRE(start(dir));
+
+    auto count = [&] {
+        file_info info;
+        int n = 0;
+        read_file(dir / "telemetry-0.tlm", info, [&](const event&) { n++; });
+        return n;
+    };
+
+    // bem menos que um bloco: só sai pelo tick() depois do intervalo
+    for (int i = 0; i < 3; i++) emit(event_type::wall_bounce);
+    tick();
+    std::this_thread::sleep_for(50ms);
+    CHECK(count() == 0);
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(flush_interval_ms));
+    tick();
+    int seen = 0;
+    for (int i = 0; i < 100 && (seen = count()) < 3; i++) std::this_thread::sleep_for(10ms);
+    CHECK(seen == 3); // no arquivo com a sessão ainda aberta
+
+    stop();
+    std::filesystem::remove_all(dir);
+}
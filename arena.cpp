@@ -0,0 +1,186 @@
+#include <algorithm>
+#include <sstream>
+#include <boost/property_tree/ptree.hpp>
+#include <boost/property_tree/info_parser.hpp>
+#include "arena.h"
+#include "gvar.h"
+
+namespace
+{
+	using pong::rect;
+
+	rect merge(const rect& a, const rect& b) noexcept
+	{
+		const float left = std::min(a.left, b.left), top = std::min(a.top, b.top);
+		const float right = std::max(a.left + a.width, b.left + b.width);
+		const float bottom = std::max(a.top + a.height, b.top + b.height);
+		return { left, top, right - left, bottom - top };
+	}
+
+	// "x y largura altura"
+	bool parse_rect(const std::string& text, rect& out)
+	{
+		std::istringstream in(text);
+		in >> out.left >> out.top >> out.width >> out.height;
+		return !in.fail() && out.width > 0 && out.height > 0;
+	}
+}
+
+pong::rect_bvh::rect_bvh(std::vector<rect> rects) : items(std::move(rects))
+{
+	if (items.empty())
+		return;
+
+	// árvore binária com folhas de até leaf_size: no máximo 2n nós
+	nodes.reserve(2 * (items.size() / leaf_size + 1));
+	nodes.emplace_back();
+	build(0, 0, std::uint32_t(items.size()), 1);
+}
+
+void pong::rect_bvh::build(std::uint32_t index, std::uint32_t begin, std::uint32_t end, int level)
+{
+	levels = std::max(levels, level);
+
+	rect box = items[begin];
+	for (auto i = begin + 1; i < end; i++) {
+		box = merge(box, items[i]);
+	}
+	nodes[index].box = box;
+
+	if (end - begin <= leaf_size)
+	{
+		nodes[index].first = begin;
+		nodes[index].count = end - begin;
+		return;
+	}
+
+	// corta no meio pelo eixo mais comprido, pela mediana dos centros
+	const bool byX = box.width >= box.height;
+	const auto mid = begin + (end - begin) / 2;
+	std::nth_element(items.begin() + begin, items.begin() + mid, items.begin() + end,
+		[byX](const rect& a, const rect& b) {
+			return byX ? a.left + a.width / 2 < b.left + b.width / 2
+				: a.top + a.height / 2 < b.top + b.height / 2;
+		});
+
+	const auto left = std::uint32_t(nodes.size());
+	nodes.emplace_back();
+	nodes.emplace_back();
+	nodes[index].first = left;
+	nodes[index].count = 0;
+
+	build(left, begin, mid, level + 1);
+	build(left + 1, mid, end, level + 1);
+}
+
+bool pong::rect_bvh::any(const rect& area) const
+{
+	bool hit = false;
+	query(area, [&](const rect&) { hit = true; });
+	return hit;
+}
+
+
+void pong::arena::compile()
+{
+	std::vector<rect> all = walls;
+	all.insert(all.end(), obstacles.begin(), obstacles.end());
+	solids = rect_bvh(std::move(all));
+
+	const rect field = { {}, size };
+	goalsInside = std::any_of(goals.begin(), goals.end(), [&](auto& g) { return collision(g.area, field); });
+}
+
+std::shared_ptr<const pong::arena> pong::arena::standard(size2d area)
+{
+	// bordas com 95% da largura, 25 de altura, margem 6
+	const size2d border = { area.x * .95f, 25 };
+	const float left = (area.x - border.x) / 2;
+
+	auto a = std::make_shared<arena>();
+	a->name = "standard";
+	a->size = area;
+	a->top = { left, 6, border.x, border.y };
+	a->bottom = { left, area.y - 6 - border.y, border.x, border.y };
+	a->walls = { a->top, a->bottom };
+
+	// a bola inteira fora da quadra, de qualquer altura
+	a->goals = {
+		{ { -area.x, -area.y, area.x, 3 * area.y }, playerid::two },
+		{ { area.x, -area.y, area.x, 3 * area.y }, playerid::one },
+	};
+	a->compile();
+	return a;
+}
+
+std::shared_ptr<const pong::arena> pong::arena::load(const std::filesystem::path& file)
+{
+	namespace pt = boost::property_tree;
+
+	pt::ptree tree;
+	try {
+		pt::read_info(file.string(), tree);
+	}
+	catch (const pt::info_parser_error& e) {
+		spdlog::error("arena {}: {}", file.string(), e.what());
+		return nullptr;
+	}
+
+	auto a = std::make_shared<arena>();
+	a->name = tree.get("name", file.stem().string());
+
+	auto fail = [&](std::string_view what) {
+		spdlog::error("arena {}: {}", file.string(), what);
+		return nullptr;
+	};
+
+	std::istringstream sizeIn(tree.get("size", ""));
+	if (!(sizeIn >> a->size.x >> a->size.y) || a->size.x <= 0 || a->size.y <= 0)
+		return fail("missing or bad 'size'");
+	// saque, view e menus são feitos pra área de jogo: outro tamanho
+	// sairia descentrado e cortado
+	if (a->size.x != gvar::playarea_width || a->size.y != gvar::playarea_height)
+		return fail(fmt::format("'size' must be the play area, {} {}", gvar::playarea_width, gvar::playarea_height));
+
+	if (!parse_rect(tree.get("borders.top", ""), a->top) || !parse_rect(tree.get("borders.bottom", ""), a->bottom))
+		return fail("'borders' needs 'top' and 'bottom' rects (x y width height)");
+	if (a->top.top + a->top.height >= a->bottom.top)
+		return fail("top border must be above the bottom one");
+	a->walls = { a->top, a->bottom };
+
+	// seções opcionais; get_child devolve referência pro default
+	const pt::ptree none;
+	rect r;
+	for (auto& [key, node] : tree.get_child("walls", none))
+	{
+		if (!parse_rect(node.data(), r))
+			return fail(fmt::format("bad wall '{}'", node.data()));
+		a->walls.push_back(r);
+	}
+	for (auto& [key, node] : tree.get_child("obstacles", none))
+	{
+		if (!parse_rect(node.data(), r))
+			return fail(fmt::format("bad obstacle '{}'", node.data()));
+		a->obstacles.push_back(r);
+	}
+
+	bool scores[2] = {};
+	for (auto& [key, node] : tree.get_child("goals", none))
+	{
+		if (key != "player1" && key != "player2")
+			return fail(fmt::format("goal zones are 'player1' or 'player2', not '{}'", key));
+		if (!parse_rect(node.data(), r))
+			return fail(fmt::format("bad goal zone '{}'", node.data()));
+
+		const auto who = key == "player1" ? playerid::one : playerid::two;
+		scores[int(who)] = true;
+		a->goals.push_back({ r, who });
+	}
+	if (!scores[0] || !scores[1])
+		return fail("each player needs at least one goal zone");
+
+	a->compile();
+	spdlog::info("arena '{}': {} walls, {} obstacles, {} goal zones, bvh {} nodes (depth {})", a->name,
+		a->walls.size(), a->obstacles.size(), a->goals.size(), a->solids.node_count(), a->solids.depth());
+	return a;
+}
@@ -0,0 +1,150 @@
+#pragma once
+// arena carregável (default-arena.info): bordas, paredes, obstáculos e zonas
+// de gol. Paredes e obstáculos viram uma BVH na carga; a física só consulta
+// a BVH, sem transform nem laço por todos os retângulos
+#include <algorithm>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <span>
+#include <string>
+#include <vector>
+#include "common.h"
+
+namespace pong
+{
+	// caixas com tamanho positivo, bordas encostando não contam
+	inline bool collision(const rect& a, const rect& b) noexcept
+	{
+		return a.left < b.left + b.width && b.left < a.left + a.width
+			&& a.top < b.top + b.height && b.top < a.top + a.height;
+	}
+
+	inline bool contains(const rect& outer, const rect& inner) noexcept
+	{
+		return inner.left >= outer.left && inner.top >= outer.top
+			&& inner.left + inner.width <= outer.left + outer.width
+			&& inner.top + inner.height <= outer.top + outer.height;
+	}
+
+	// caixa em pos (meia-medida half) dentro de wall: inverte vel no eixo em
+	// que entrou menos, como a bola de match. false se já estava saindo
+	inline bool bounce(point pos, vec2 half, vec2& vel, const rect& wall) noexcept
+	{
+		const float dx = std::min(pos.x + half.x - wall.left, wall.left + wall.width - (pos.x - half.x));
+		const float dy = std::min(pos.y + half.y - wall.top, wall.top + wall.height - (pos.y - half.y));
+
+		if (dy <= dx)
+		{
+			const float away = pos.y < wall.top + wall.height / 2 ? -1.f : 1.f;
+			if (vel.y * away >= 0)
+				return false;
+			vel.y = -vel.y;
+		}
+		else
+		{
+			const float away = pos.x < wall.left + wall.width / 2 ? -1.f : 1.f;
+			if (vel.x * away >= 0)
+				return false;
+			vel.x = -vel.x;
+		}
+		return true;
+	}
+
+	// BVH de retângulos estáticos, montada uma vez. Nós num vector só,
+	// filhos lado a lado (direito = esquerdo + 1), consulta sem recursão
+	class rect_bvh
+	{
+	public:
+		static constexpr std::uint32_t leaf_size = 4;
+
+		rect_bvh() = default;
+		explicit rect_bvh(std::vector<rect> rects);
+
+		// f(const rect&) pra cada retângulo que encosta em area
+		template<class F>
+		void query(const rect& area, F&& f) const
+		{
+			if (nodes.empty())
+				return;
+
+			// arena simples (só as bordas): a raiz já é folha
+			if (nodes[0].count > 0)
+			{
+				for (auto i = 0u; i < nodes[0].count; i++) {
+					if (collision(items[i], area)) f(items[i]);
+				}
+				return;
+			}
+
+			std::uint32_t stack[64];
+			int top = 0;
+			stack[top++] = 0;
+
+			while (top > 0)
+			{
+				const auto& n = nodes[stack[--top]];
+				if (!collision(n.box, area))
+					continue;
+
+				if (n.count > 0)
+				{
+					for (auto i = n.first; i < n.first + n.count; i++) {
+						if (collision(items[i], area)) f(items[i]);
+					}
+				}
+				else
+				{
+					stack[top++] = n.first;
+					stack[top++] = n.first + 1;
+				}
+			}
+		}
+
+		bool any(const rect& area) const;
+
+		std::span<const rect> rects() const noexcept { return items; }
+		std::size_t node_count() const noexcept { return nodes.size(); }
+		int depth() const noexcept { return levels; }
+
+	private:
+		struct node
+		{
+			rect box;
+			std::uint32_t first = 0, count = 0; // count 0: interno, first = filho esquerdo
+		};
+
+		std::vector<node> nodes;
+		std::vector<rect> items; // reordenados na montagem, folhas apontam pra faixas
+		int levels = 0;
+
+		void build(std::uint32_t index, std::uint32_t begin, std::uint32_t end, int level);
+	};
+
+	struct goal_zone
+	{
+		rect area;       // a bola inteira dentro = gol
+		playerid scorer; // quem marca
+	};
+
+	struct arena
+	{
+		std::string name;
+		size2d size;
+		rect top, bottom; // bordas da pista: raquetes andam entre elas
+		std::vector<rect> walls; // top e bottom entram aqui também
+		std::vector<rect> obstacles;
+		std::vector<goal_zone> goals;
+
+		rect_bvh solids; // walls + obstacles
+		bool goalsInside = false; // alguma zona de gol dentro de {0, 0, size}
+
+		// monta solids; chamar depois de mexer nas listas
+		void compile();
+
+		// a quadra de sempre, como o background desenhava
+		static std::shared_ptr<const arena> standard(size2d area);
+		// nullptr se não abrir ou estiver errado (motivo no log)
+		static std::shared_ptr<const arena> load(const std::filesystem::path& file);
+	};
+}
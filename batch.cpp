@@ -0,0 +1,186 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <thread>
+#include <fmt/format.h>
+#include "batch.h"
+
+bool pong::parse_gamemode(std::string_view name, gamemode& out) noexcept
+{
+	if (name == "singleplayer") out = gamemode::singleplayer;
+	else if (name == "multiplayer") out = gamemode::multiplayer;
+	else if (name == "aitest") out = gamemode::aitest;
+	else return false;
+	return true;
+}
+
+std::string_view pong::gamemode_name(gamemode mode) noexcept
+{
+	static constexpr std::string_view names[] = { "singleplayer", "multiplayer", "aitest" };
+	return names[int(mode)];
+}
+
+pong::match_outcome pong::play_match(match& sim, const batch_config& cfg, int index, std::vector<point_record>& points)
+{
+	// id da partida: a chave do RNG, diferente pra cada índice
+	sim.rematch(squares::key(cfg.seed) + std::uint64_t(index), cfg.guts);
+	sim.mute(true);
+	sim.apply({ sim_message::mode, std::uint8_t(cfg.mode) });
+	sim.apply({ sim_message::resume });
+
+	// a partida em si não tem sorte: a seed varia onde as raquetes
+	// começam e em que fase a IA reage
+	auto start = sim.state();
+	auto dice = sim.random();
+	for (auto& p : start.paddles)
+	{
+		p.pos.y += float(dice.range(-300, 300));
+		p.aiWait = dice.range(1, gvar::tick_rate / 10);
+	}
+	sim.restore(start);
+
+	match_outcome out;
+	while (out.score[0] < cfg.points && out.score[1] < cfg.points && sim.ticks() < cfg.maxTicks)
+	{
+		if (sim.waiting_to_serve()) {
+			sim.apply({ sim_message::serve });
+		}
+		sim.step();
+
+		for (auto& ev : sim.events())
+		{
+			if (ev.kind == phys_event::paddle_hit) {
+				out.hits++;
+			}
+			else if (ev.kind == phys_event::goal)
+			{
+				const auto f = sim.frame();
+				out.score[0] = f.score.first;
+				out.score[1] = f.score.second;
+				points.push_back({ sim.ticks(), f.lastRally, ev.player });
+			}
+		}
+	}
+
+	out.ticks = sim.ticks();
+	out.hash = hash(sim.state());
+	return out;
+}
+
+bool pong::open_results(columnar::writer& out, const std::filesystem::path& file)
+{
+	using columnar::column_type;
+	return out.open(file, {
+		{ "sweep_point", column_type::u32 },
+		{ "match", column_type::u32 },
+		{ "tick", column_type::u64 },
+		{ "scorer", column_type::u32 },
+		{ "rally", column_type::i32 },
+	});
+}
+
+void pong::append_points(columnar::writer::appender& out, std::uint32_t sweepPoint, int index,
+	std::span<const point_record> points) noexcept
+{
+	for (auto& p : points) {
+		out.append(sweepPoint, std::uint32_t(index), p.tick, std::uint32_t(p.scorer), p.rally);
+	}
+}
+
+pong::court_t pong::batch_court(const batch_config& cfg)
+{
+	return cfg.map ? court_t::from(cfg.map) : court_t::standard({ gvar::playarea_width, gvar::playarea_height });
+}
+
+pong::batch_result pong::run_batch(const batch_config& cfg, columnar::writer* results)
+{
+	const auto court = batch_court(cfg);
+	const int threads = std::clamp(cfg.threads > 0 ? cfg.threads : int(std::thread::hardware_concurrency()),
+		1, std::max(cfg.matches, 1));
+
+	batch_result total;
+	total.threads = threads;
+	std::mutex totalLock;
+	std::atomic<int> next{ 0 };
+
+	const auto start = std::chrono::steady_clock::now();
+	{
+		std::vector<std::jthread> workers;
+		for (int t = 0; t < threads; t++)
+		{
+			workers.emplace_back([&] {
+				batch_result local;
+				match sim(court);
+				std::vector<point_record> points;
+				points.reserve(2 * std::size_t(std::max(cfg.points, 1)));
+				columnar::writer::appender rows;
+				if (results) rows = results->make_appender();
+
+				for (int i; (i = next.fetch_add(1, std::memory_order_relaxed)) < cfg.matches;)
+				{
+					points.clear();
+					const auto m = play_match(sim, cfg, i, points);
+					for (auto& p : points) local.rallies.push_back(p.rally);
+					append_points(rows, 0, i, points);
+
+					local.matches++;
+					local.ticks += m.ticks;
+					local.hits += m.hits;
+					local.points[0] += m.score[0];
+					local.points[1] += m.score[1];
+					if (m.score[0] >= cfg.points) local.wins[0]++;
+					else if (m.score[1] >= cfg.points) local.wins[1]++;
+					else local.capped++;
+					local.checksum += m.hash;
+				}
+
+				std::scoped_lock _lock_(totalLock);
+				total.matches += local.matches;
+				total.capped += local.capped;
+				total.ticks += local.ticks;
+				total.hits += local.hits;
+				for (int p = 0; p < 2; p++) {
+					total.points[p] += local.points[p];
+					total.wins[p] += local.wins[p];
+				}
+				total.rallies.insert(total.rallies.end(), local.rallies.begin(), local.rallies.end());
+				total.checksum += local.checksum;
+			});
+		}
+	}
+	total.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	return total;
+}
+
+void pong::print_batch(std::FILE* out, const batch_config& cfg, batch_result& r)
+{
+	fmt::print(out, "sfPong batch: {} matches, {}, seed {}, first to {}, {} threads\n",
+		r.matches, gamemode_name(cfg.mode), cfg.seed, cfg.points, r.threads);
+	if (!cfg.guts.builtin())
+	{
+		auto& g = cfg.guts;
+		fmt::print(out, "  guts: paddle kb {} max {} size {}x{}, ball speed {} accel {} max {} radius {}\n",
+			g.paddle_kb_speed, g.paddle_max_speed, g.paddle_width, g.paddle_height,
+			g.ball_speed, g.ball_acceleration, g.ball_max_speed, g.ball_radius);
+	}
+	fmt::print(out, "  points: P1 {}  P2 {}   wins: P1 {}  P2 {}  capped {}\n",
+		r.points[0], r.points[1], r.wins[0], r.wins[1], r.capped);
+
+	if (!r.rallies.empty())
+	{
+		auto& v = r.rallies;
+		std::sort(v.begin(), v.end());
+		const auto pct = [&](double p) { return v[std::min(v.size() - 1, std::size_t(p * v.size()))]; };
+		double sum = 0;
+		for (auto x : v) sum += x;
+		fmt::print(out, "  rally: mean {:.1f}  p50 {}  p90 {}  max {}  ({} hits)\n",
+			sum / v.size(), pct(.5), pct(.9), v.back(), r.hits);
+	}
+	else fmt::print(out, "  rally: no points ({} hits)\n", r.hits);
+
+	const auto rate = r.seconds > 0 ? r.ticks / r.seconds : 0;
+	fmt::print(out, "  ticks: {} in {:.3f} s = {:.2f} M ticks/s ({:.2f} M/s per thread)\n",
+		r.ticks, r.seconds, rate / 1e6, rate / 1e6 / r.threads);
+	fmt::print(out, "  checksum: {:016x}\n", r.checksum);
+}
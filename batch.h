@@ -0,0 +1,75 @@
+#pragma once
+// partidas em lote, sem janela: --simulate N.
+// Mesmas regras do game::update (o saque é automático, ninguém aperta
+// Enter). Os resultados não dependem do número de threads
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <memory>
+#include <string_view>
+#include <vector>
+#include "columnar.h"
+#include "gvar.h"
+#include "match.h"
+
+namespace pong
+{
+	struct batch_config
+	{
+		int matches = 0;
+		int threads = 0; // 0 = uma por núcleo
+		std::uint64_t seed = 1337;
+		gamemode mode = gamemode::aitest;
+		int points = 10; // ganha quem fizer primeiro
+		std::uint64_t maxTicks = 10ull * 60 * gvar::tick_rate; // 10 min de jogo e desiste
+		physics_profile guts; // --guts
+		std::shared_ptr<const arena> map; // --arena; nullptr: a quadra padrão
+	};
+
+	// a quadra das partidas de cfg
+	court_t batch_court(const batch_config& cfg);
+
+	struct batch_result
+	{
+		std::uint64_t matches = 0, capped = 0; // capped: bateram em maxTicks
+		std::uint64_t ticks = 0, hits = 0;
+		std::uint64_t points[2] = {}, wins[2] = {};
+		std::vector<int> rallies; // rebatidas de cada ponto
+		std::uint64_t checksum = 0; // soma dos hashes dos estados finais
+		double seconds = 0;
+		int threads = 0;
+	};
+
+	// uma partida do lote
+	struct match_outcome
+	{
+		std::int32_t score[2] = {};
+		std::uint64_t ticks = 0, hits = 0;
+		std::uint64_t hash = 0; // do estado final
+	};
+
+	// um ponto da partida
+	struct point_record
+	{
+		std::uint64_t tick; // quando saiu o gol
+		std::int32_t rally; // rebatidas
+		playerid scorer;
+	};
+
+	bool parse_gamemode(std::string_view name, gamemode& out) noexcept;
+	std::string_view gamemode_name(gamemode mode) noexcept;
+
+	// a partida index de cfg em sim, que é reaproveitado (rematch): sem
+	// alocar nada. Os pontos vão pro fim de points
+	match_outcome play_match(match& sim, const batch_config& cfg, int index, std::vector<point_record>& points);
+
+	// --results: uma linha por ponto (sweep_point, match, tick, scorer, rally).
+	// sweep_point é 0 no batch
+	bool open_results(columnar::writer& out, const std::filesystem::path& file);
+	void append_points(columnar::writer::appender& out, std::uint32_t sweepPoint, int index,
+		std::span<const point_record> points) noexcept;
+
+	// results: --results aberto, ou nullptr
+	batch_result run_batch(const batch_config& cfg, columnar::writer* results = nullptr);
+	void print_batch(std::FILE* out, const batch_config& cfg, batch_result& r);
+}
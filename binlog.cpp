@@ -0,0 +1,270 @@
+#include "binlog.h"
+#include "mpmc_queue.h"
+
+#include <array>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <fmt/format.h>
+#include <fmt/args.h>
+#include <spdlog/spdlog.h>
+
+using namespace std::literals;
+using namespace pong::binlog;
+
+std::atomic<bool> pong::binlog::detail::running{ false };
+std::chrono::steady_clock::time_point pong::binlog::detail::t0;
+
+namespace
+{
+	constexpr char magic[4] = { 'S', 'F', 'P', 'L' };
+	constexpr std::uint32_t format_version = 1;
+	constexpr std::size_t max_formats = 1024;
+
+	enum chunk : std::uint8_t { chunk_format = 1, chunk_record = 2 };
+
+	struct file_header
+	{
+		char magic[4];
+		std::uint32_t version;
+	};
+
+	struct format_header
+	{
+		std::uint16_t id;
+		level lvl;
+		std::uint16_t length;
+	};
+
+	struct format_entry
+	{
+		level lvl;
+		const char* fmt;
+	};
+
+	std::mutex formats_mtx;
+	std::array<format_entry, max_formats> formats;
+	std::atomic<std::uint16_t> format_count{ 0 };
+
+	using queue_t = util::mpmc_queue<record, 8192>;
+	std::unique_ptr<queue_t> queue;
+	std::atomic<std::uint64_t> dropped_{ 0 };
+	std::thread writer;
+	std::FILE* out_file = nullptr;
+	bool mirror = false;
+
+	auto to_spdlog(level lvl) -> spdlog::level::level_enum
+	{
+		switch (lvl)
+		{
+		case level::debug: return spdlog::level::debug;
+		case level::info: return spdlog::level::info;
+		case level::warn: return spdlog::level::warn;
+		default: return spdlog::level::err;
+		}
+	}
+
+	auto format_record(const char* fmt, const record& r) -> std::string
+	{
+		fmt::dynamic_format_arg_store<fmt::format_context> store;
+		std::array<std::string_view, max_args> tags;
+
+		for (int i = 0; i < r.nargs && i < max_args; i++)
+		{
+			auto bits = r.args[i];
+			switch (r.types[i])
+			{
+			case arg_type::i64: store.push_back(std::int64_t(bits)); break;
+			case arg_type::u64: store.push_back(bits); break;
+			case arg_type::boolean: store.push_back(bits != 0); break;
+			case arg_type::f64: {
+				double d;
+				std::memcpy(&d, &bits, sizeof(d));
+				store.push_back(d);
+			} break;
+			case arg_type::tag: {
+				auto* text = reinterpret_cast<const char*>(&r.args[i]);
+				tags[i] = std::string_view(text, strnlen(text, sizeof(bits)));
+				store.push_back(tags[i]);
+			} break;
+			default: store.push_back("?"); break;
+			}
+		}
+
+		try
+		{
+			return fmt::vformat(fmt, store);
+		}
+		catch (const fmt::format_error& e)
+		{
+			return fmt::format("{} [format error: {}]", fmt, e.what());
+		}
+	}
+
+	void write_record(const record& r, std::vector<bool>& defined)
+	{
+		if (r.id >= format_count.load(std::memory_order_acquire))
+			return;
+
+		auto& entry = formats[r.id];
+
+		// o formato vai pro arquivo antes do primeiro registro que o usa
+		if (!defined[r.id])
+		{
+			defined[r.id] = true;
+			format_header fh{ r.id, entry.lvl, std::uint16_t(std::strlen(entry.fmt)) };
+			std::fputc(chunk_format, out_file);
+			std::fwrite(&fh, sizeof(fh), 1, out_file);
+			std::fwrite(entry.fmt, 1, fh.length, out_file);
+		}
+
+		std::fputc(chunk_record, out_file);
+		std::fwrite(&r, sizeof(r), 1, out_file);
+
+		if (mirror) {
+			spdlog::log(to_spdlog(entry.lvl), "{}", format_record(entry.fmt, r));
+		}
+	}
+
+	void writer_loop()
+	{
+		std::vector<bool> defined(max_formats);
+		record r{};
+
+		for (;;)
+		{
+			bool any = false;
+			while (queue->pop(r)) {
+				write_record(r, defined);
+				any = true;
+			}
+
+			if (!any)
+			{
+				if (!detail::running.load(std::memory_order_acquire))
+					break;
+				std::fflush(out_file);
+				std::this_thread::sleep_for(1ms);
+			}
+		}
+
+		std::fflush(out_file);
+	}
+}
+
+std::uint16_t pong::binlog::register_format(level lvl, const char* fmt) noexcept
+{
+	std::lock_guard _lk_(formats_mtx);
+
+	auto id = format_count.load(std::memory_order_relaxed);
+	if (id >= max_formats) {
+		return std::uint16_t(max_formats); // descartado em write_record
+	}
+
+	formats[id] = { lvl, fmt };
+	format_count.store(id + 1, std::memory_order_release);
+	return id;
+}
+
+void pong::binlog::detail::push(const record& r) noexcept
+{
+	if (!queue->push(r)) {
+		dropped_.fetch_add(1, std::memory_order_relaxed);
+	}
+}
+
+bool pong::binlog::start(const std::filesystem::path& file, bool mirror_to_spdlog)
+{
+	if (detail::running)
+		return true;
+
+	out_file = std::fopen(file.string().c_str(), "wb");
+	if (!out_file) {
+		spdlog::error("binlog: failed to open {}", file.string());
+		return false;
+	}
+
+	file_header hdr;
+	std::memcpy(hdr.magic, magic, sizeof(magic));
+	hdr.version = format_version;
+	std::fwrite(&hdr, sizeof(hdr), 1, out_file);
+
+	if (!queue)
+		queue = std::make_unique<queue_t>();
+
+	mirror = mirror_to_spdlog;
+	detail::t0 = std::chrono::steady_clock::now();
+	detail::running.store(true, std::memory_order_release); // publica t0
+	writer = std::thread(writer_loop);
+	return true;
+}
+
+void pong::binlog::stop()
+{
+	if (!detail::running)
+		return;
+
+	detail::running = false;
+	writer.join();
+
+	std::fclose(out_file);
+	out_file = nullptr;
+
+	if (auto n = dropped()) {
+		spdlog::warn("binlog: {} records dropped", n);
+	}
+}
+
+std::uint64_t pong::binlog::dropped() noexcept
+{
+	return dropped_.load(std::memory_order_relaxed);
+}
+
+bool pong::binlog::decode(const std::filesystem::path& file, std::FILE* out)
+{
+	constexpr std::string_view level_names[] = { "debug", "info", "warn", "error" };
+
+	std::unique_ptr<std::FILE, int(*)(std::FILE*)> in(std::fopen(file.string().c_str(), "rb"), &std::fclose);
+	if (!in)
+		return false;
+
+	file_header hdr;
+	if (std::fread(&hdr, sizeof(hdr), 1, in.get()) != 1
+		|| std::memcmp(hdr.magic, magic, sizeof(magic)) != 0
+		|| hdr.version != format_version)
+	{
+		return false;
+	}
+
+	std::vector<std::pair<level, std::string>> defs(max_formats);
+
+	for (int kind; (kind = std::fgetc(in.get())) != EOF; )
+	{
+		if (kind == chunk_format)
+		{
+			format_header fh;
+			if (std::fread(&fh, sizeof(fh), 1, in.get()) != 1 || fh.id >= max_formats)
+				return false;
+
+			auto& [lvl, text] = defs[fh.id];
+			lvl = fh.lvl;
+			text.resize(fh.length);
+			if (std::fread(text.data(), 1, fh.length, in.get()) != fh.length)
+				return false;
+		}
+		else if (kind == chunk_record)
+		{
+			record r{};
+			if (std::fread(&r, sizeof(r), 1, in.get()) != 1 || r.id >= max_formats)
+				return false;
+
+			auto& [lvl, text] = defs[r.id];
+			fmt::print(out, "[{:.6f}] [{}] {}\n", r.time_ns / 1e9, level_names[int(lvl) & 3], format_record(text.c_str(), r));
+		}
+		else return false;
+	}
+
+	return true;
+}
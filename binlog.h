@@ -0,0 +1,148 @@
+#pragma once
+// log binário assíncrono pro hot path.
+//
+// cada chamada grava só o id do formato e os argumentos crus numa fila
+// sem locks; uma thread de fundo escreve o arquivo (e opcionalmente
+// repassa o texto pro spdlog). `sfpong --decode-log arquivo` decodifica.
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <string_view>
+#include <type_traits>
+
+namespace pong::binlog
+{
+	enum class level : std::uint8_t { debug, info, warn, error };
+
+	// string curta copiada no registro (até 8 chars), ex.: nomes de enum
+	struct tag
+	{
+		char text[8] = {};
+
+		tag() = default;
+		explicit tag(std::string_view sv) noexcept {
+			std::memcpy(text, sv.data(), sv.size() < sizeof(text) ? sv.size() : sizeof(text));
+		}
+	};
+
+	enum class arg_type : std::uint8_t { none, i64, u64, f64, boolean, tag };
+
+	constexpr int max_args = 6;
+
+	struct record
+	{
+		std::uint16_t id;
+		std::uint8_t nargs;
+		arg_type types[max_args];
+		std::int64_t time_ns; // desde start()
+		std::uint64_t args[max_args];
+	};
+	static_assert(std::is_trivially_copyable_v<record>);
+
+	// registra um formato, uma vez por call site (ver PONG_LOG)
+	std::uint16_t register_format(level lvl, const char* fmt) noexcept;
+
+	bool start(const std::filesystem::path& file, bool mirror_to_spdlog = true);
+	void stop();
+	// registros perdidos com a fila cheia
+	std::uint64_t dropped() noexcept;
+
+	// imprime um log binário como texto
+	bool decode(const std::filesystem::path& file, std::FILE* out);
+
+namespace detail
+{
+	extern std::atomic<bool> running;
+	extern std::chrono::steady_clock::time_point t0;
+	void push(const record& r) noexcept;
+
+	template<class T>
+	void encode(record& r, const T& value) noexcept
+	{
+		auto& bits = r.args[r.nargs];
+		auto& type = r.types[r.nargs];
+		r.nargs++;
+
+		if constexpr (std::is_same_v<T, bool>) {
+			type = arg_type::boolean;
+			bits = value;
+		}
+		else if constexpr (std::is_same_v<T, tag>) {
+			type = arg_type::tag;
+			std::memcpy(&bits, value.text, sizeof(bits));
+		}
+		else if constexpr (std::is_enum_v<T>) {
+			type = arg_type::i64;
+			bits = std::uint64_t(std::int64_t(value));
+		}
+		else if constexpr (std::is_floating_point_v<T>) {
+			type = arg_type::f64;
+			double d = value;
+			std::memcpy(&bits, &d, sizeof(bits));
+		}
+		else if constexpr (std::is_integral_v<T> && std::is_signed_v<T>) {
+			type = arg_type::i64;
+			bits = std::uint64_t(std::int64_t(value));
+		}
+		else if constexpr (std::is_integral_v<T>) {
+			type = arg_type::u64;
+			bits = value;
+		}
+		else static_assert(!sizeof(T), "binlog: tipo de argumento não suportado");
+	}
+}
+
+	template<class... Args>
+	void write(std::uint16_t id, const Args&... args) noexcept
+	{
+		static_assert(sizeof...(Args) <= max_args);
+
+		// acquire: t0 é escrito antes de running = true
+		if (!detail::running.load(std::memory_order_acquire))
+			return;
+
+		// zerado: args sem uso e padding vão pro arquivo
+		record r{};
+		r.id = id;
+		r.nargs = 0;
+		(detail::encode(r, args), ...);
+		r.time_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+			std::chrono::steady_clock::now() - detail::t0).count();
+		detail::push(r);
+	}
+}
+
+// chamadas abaixo de PONG_LOG_ACTIVE_LEVEL somem em tempo de compilação
+// 0 = debug, 1 = info, 2 = warn, 3 = error
+#ifndef PONG_LOG_ACTIVE_LEVEL
+#	ifdef NDEBUG
+#		define PONG_LOG_ACTIVE_LEVEL 1
+#	else
+#		define PONG_LOG_ACTIVE_LEVEL 0
+#	endif
+#endif
+
+#define PONG_LOG(lvl, fmt, ...) do { \
+	static const std::uint16_t _pong_log_id_ = ::pong::binlog::register_format(lvl, fmt); \
+	::pong::binlog::write(_pong_log_id_, ##__VA_ARGS__); \
+} while (0)
+
+#if PONG_LOG_ACTIVE_LEVEL <= 0
+#	define PONG_LOG_DEBUG(fmt, ...) PONG_LOG(::pong::binlog::level::debug, fmt, ##__VA_ARGS__)
+#else
+#	define PONG_LOG_DEBUG(fmt, ...) ((void)0)
+#endif
+#if PONG_LOG_ACTIVE_LEVEL <= 1
+#	define PONG_LOG_INFO(fmt, ...) PONG_LOG(::pong::binlog::level::info, fmt, ##__VA_ARGS__)
+#else
+#	define PONG_LOG_INFO(fmt, ...) ((void)0)
+#endif
+#if PONG_LOG_ACTIVE_LEVEL <= 2
+#	define PONG_LOG_WARN(fmt, ...) PONG_LOG(::pong::binlog::level::warn, fmt, ##__VA_ARGS__)
+#else
+#	define PONG_LOG_WARN(fmt, ...) ((void)0)
+#endif
+#define PONG_LOG_ERROR(fmt, ...) PONG_LOG(::pong::binlog::level::error, fmt, ##__VA_ARGS__)
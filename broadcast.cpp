@@ -0,0 +1,371 @@
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include "broadcast.h"
+#include "gvar.h"
+#include "wire.h"
+
+using namespace std::literals;
+
+namespace
+{
+	constexpr std::uint32_t magic = 0x42504653; // "SFPB"
+	enum packet_type : std::uint8_t { hello, bye, keyframe, delta };
+
+	constexpr float pos_scale = 8, vel_scale = 64;
+	constexpr auto subscriber_timeout = 5s;
+
+	std::int32_t q(float value, float scale) { return std::int32_t(std::lround(value * scale)); }
+}
+
+pong::spectate::quantized pong::spectate::quantize(const match_frame& f) noexcept
+{
+	quantized r;
+	r.tick = std::uint32_t(f.tick);
+	auto* v = r.v;
+	*v++ = q(f.pos[0].x, pos_scale);
+	*v++ = q(f.pos[0].y, pos_scale);
+	*v++ = q(f.pos[1].x, pos_scale);
+	*v++ = q(f.pos[1].y, pos_scale);
+	*v++ = q(f.ballPos.x, pos_scale);
+	*v++ = q(f.ballPos.y, pos_scale);
+	*v++ = q(f.vel[0].y, vel_scale);
+	*v++ = q(f.vel[1].y, vel_scale);
+	*v++ = q(f.ballVel.x, vel_scale);
+	*v++ = q(f.ballVel.y, vel_scale);
+	*v++ = f.score.first;
+	*v++ = f.score.second;
+	*v++ = f.rally;
+	*v++ = f.lastRally;
+	*v++ = (f.paused ? 1 : 0) | (f.ai[0] ? 2 : 0) | (f.ai[1] ? 4 : 0);
+	return r;
+}
+
+pong::match_frame pong::spectate::dequantize(const quantized& r) noexcept
+{
+	match_frame f;
+	f.tick = r.tick;
+	auto* v = r.v;
+	f.pos[0] = { v[0] / pos_scale, v[1] / pos_scale };
+	f.pos[1] = { v[2] / pos_scale, v[3] / pos_scale };
+	f.ballPos = { v[4] / pos_scale, v[5] / pos_scale };
+	f.vel[0] = { 0, v[6] / vel_scale };
+	f.vel[1] = { 0, v[7] / vel_scale };
+	f.ballVel = { v[8] / vel_scale, v[9] / vel_scale };
+	f.score = { v[10], v[11] };
+	f.rally = v[12];
+	f.lastRally = v[13];
+	f.paused = v[14] & 1;
+	f.ai[0] = v[14] & 2;
+	f.ai[1] = v[14] & 4;
+	return f;
+}
+
+std::size_t pong::spectate::encode(const quantized& r, const quantized* base, void* buf, std::size_t cap) noexcept
+{
+	util::wire_writer w(buf, cap);
+	w.put(magic).put(std::uint8_t(base ? delta : keyframe)).put(r.tick);
+
+	if (!base)
+	{
+		for (auto value : r.v)
+			w.put_svarint(value);
+	}
+	else
+	{
+		std::uint16_t mask = 0;
+		for (int i = 0; i < fields; i++)
+			if (r.v[i] != base->v[i])
+				mask |= 1 << i;
+
+		w.put(base->tick).put(mask);
+		for (int i = 0; i < fields; i++)
+			if (mask & (1 << i))
+				w.put_svarint(std::int64_t(r.v[i]) - base->v[i]);
+	}
+
+	return w.ok() ? w.size() : 0;
+}
+
+bool pong::spectate::decode(const void* buf, std::size_t size, const quantized* base, quantized& out, bool& isKey) noexcept
+{
+	util::wire_reader r(buf, size);
+	if (r.get<std::uint32_t>() != magic)
+		return false;
+
+	const auto type = r.get<std::uint8_t>();
+	out.tick = r.get<std::uint32_t>();
+	isKey = type == keyframe;
+
+	if (type == keyframe)
+	{
+		for (auto& value : out.v)
+			value = std::int32_t(r.get_svarint());
+	}
+	else if (type == delta)
+	{
+		const auto keyTick = r.get<std::uint32_t>();
+		const auto mask = r.get<std::uint16_t>();
+		if (!base || base->tick != keyTick)
+			return false;
+
+		for (int i = 0; i < fields; i++)
+			out.v[i] = mask & (1 << i) ? std::int32_t(base->v[i] + r.get_svarint()) : base->v[i];
+	}
+	else return false;
+
+	return r.ok();
+}
+
+
+pong::broadcaster::broadcaster(unsigned short port)
+{
+	if (socket.bind(port) != sf::Socket::Done) {
+		spdlog::error("broadcast: failed to bind udp port {}", port);
+		return;
+	}
+	socket.setBlocking(false);
+	subs.reserve(64);
+	bound = true;
+
+	worker = std::jthread([this](std::stop_token stop) { run(stop); });
+	spdlog::info("broadcast: listening for spectators on port {}", port);
+}
+
+pong::broadcaster::~broadcaster()
+{
+	worker.request_stop();
+	if (worker.joinable()) {
+		worker.join();
+	}
+}
+
+void pong::broadcaster::run(std::stop_token stop)
+{
+	while (!stop.stop_requested())
+	{
+		receive();
+
+		match_frame frame;
+		while (frames.pop(frame)) {
+			send(frame);
+		}
+
+		const auto now = std::chrono::steady_clock::now();
+		std::erase_if(subs, [&](const subscriber& s) { return now - s.lastSeen > subscriber_timeout; });
+		subscriberCount.store(int(subs.size()), std::memory_order_relaxed);
+
+		std::this_thread::sleep_for(1ms);
+	}
+}
+
+void pong::broadcaster::receive()
+{
+	std::uint8_t buf[64];
+	std::size_t size = 0;
+	sf::IpAddress addr;
+	unsigned short port = 0;
+
+	while (socket.receive(buf, sizeof(buf), size, addr, port) == sf::Socket::Done)
+	{
+		util::wire_reader r(buf, size);
+		if (r.get<std::uint32_t>() != magic)
+			continue;
+
+		const auto type = r.get<std::uint8_t>();
+		auto it = std::find_if(subs.begin(), subs.end(), [&](auto& s) { return s.addr == addr && s.port == port; });
+
+		if (type == hello)
+		{
+			if (it != subs.end()) {
+				it->lastSeen = std::chrono::steady_clock::now();
+			}
+			else if (subs.size() < max_subscribers) {
+				subs.push_back({ addr, port, std::chrono::steady_clock::now() });
+				// o novo inscrito precisa de um keyframe
+				haveKey = false;
+			}
+		}
+		else if (type == bye && it != subs.end()) {
+			subs.erase(it);
+		}
+	}
+}
+
+void pong::broadcaster::send(const match_frame& frame)
+{
+	if (subs.empty()) {
+		haveKey = false;
+		return;
+	}
+
+	// pausado a partida republica o mesmo estado: não manda de novo
+	const auto state = spectate::quantize(frame);
+	if (haveKey && state.tick == last.tick && std::equal(std::begin(state.v), std::end(state.v), last.v))
+		return;
+	last = state;
+
+	const bool newKey = !haveKey || state.tick < key.tick || state.tick - key.tick >= spectate::keyframe_interval;
+
+	// codifica uma vez, manda pra todos
+	std::uint8_t buf[128];
+	const auto size = spectate::encode(state, newKey ? nullptr : &key, buf, sizeof(buf));
+	if (newKey) {
+		key = state;
+		haveKey = true;
+	}
+
+	for (auto& s : subs) {
+		socket.send(buf, size, s.addr, s.port);
+	}
+	sentBytes.fetch_add(size * subs.size(), std::memory_order_relaxed);
+}
+
+
+pong::spectator::spectator(const std::string& host)
+{
+	const auto colon = host.rfind(':');
+	const auto port = std::string_view(host).substr(colon == host.npos ? host.size() : colon + 1);
+	hostAddr = sf::IpAddress(host.substr(0, colon));
+
+	if (colon == host.npos || hostAddr == sf::IpAddress::None
+		|| std::from_chars(port.data(), port.data() + port.size(), hostPort).ec != std::errc()) {
+		spdlog::error("spectate: host must be host:port, got '{}'", host);
+		return;
+	}
+
+	if (socket.bind(sf::Socket::AnyPort) != sf::Socket::Done) {
+		spdlog::error("spectate: failed to bind a udp port");
+		return;
+	}
+	socket.setBlocking(false);
+	bound = true;
+
+	for (auto& r : ring) {
+		r.tick = UINT32_MAX;
+	}
+	lastUpdate = clock::now();
+	hello(packet_type::hello);
+	spdlog::info("spectate: watching {}", host);
+}
+
+pong::spectator::~spectator()
+{
+	if (bound) {
+		hello(packet_type::bye);
+	}
+}
+
+void pong::spectator::hello(std::uint8_t type)
+{
+	std::uint8_t buf[8];
+	util::wire_writer w(buf, sizeof(buf));
+	w.put(magic).put(type);
+	socket.send(buf, w.size(), hostAddr, hostPort);
+	lastHello = clock::now();
+}
+
+void pong::spectator::receive()
+{
+	std::uint8_t buf[128];
+	std::size_t size = 0;
+	sf::IpAddress addr;
+	unsigned short port = 0;
+
+	while (socket.receive(buf, sizeof(buf), size, addr, port) == sf::Socket::Done)
+	{
+		if (addr != hostAddr)
+			continue;
+
+		spectate::quantized state;
+		bool isKey = false;
+		if (!spectate::decode(buf, size, haveKey ? &key : nullptr, state, isKey))
+			continue;
+
+		st.packets++;
+		if (isKey) {
+			key = state;
+			haveKey = true;
+		}
+
+		ring[state.tick % buffered] = state;
+		if (!haveState)
+		{
+			haveState = true;
+			latest = state.tick;
+			renderTick = latest - interp_delay;
+		}
+		else if (state.tick > latest)
+		{
+			st.lost += state.tick - latest - 1;
+			latest = state.tick;
+		}
+	}
+}
+
+std::optional<pong::match_frame> pong::spectator::update()
+{
+	if (!bound)
+		return std::nullopt;
+
+	receive();
+
+	const auto now = clock::now();
+	const auto dt = std::chrono::duration<double>(now - lastUpdate).count();
+	lastUpdate = now;
+
+	if (now - lastHello > 1s) {
+		hello(packet_type::hello);
+	}
+
+	if (!haveState)
+		return std::nullopt;
+
+	// o relógio local anda no ritmo do tick; o erro contra o alvo é
+	// corrigido devagar, ou de uma vez se ficou muito longe
+	const double target = latest - interp_delay;
+	renderTick += dt * gvar::tick_rate;
+	const auto err = target - renderTick;
+	renderTick = std::abs(err) > 10 ? target : renderTick + err * 0.05;
+
+	st.renderTick = renderTick;
+	st.latestTick = latest;
+
+	// os dois ticks recebidos em volta de renderTick
+	const auto* a = static_cast<const spectate::quantized*>(nullptr);
+	const auto* b = a;
+	const auto t0 = std::uint32_t(std::max(renderTick, 0.0));
+	for (std::uint32_t i = 0; i < buffered && i <= t0 && !a; i++) {
+		if (auto& r = ring[(t0 - i) % buffered]; r.tick == t0 - i) a = &r;
+	}
+	for (auto t = t0 + 1; t <= latest && t - t0 < buffered && !b; t++) {
+		if (auto& r = ring[t % buffered]; r.tick == t) b = &r;
+	}
+
+	if (!a && !b) {
+		st.waiting++;
+		return std::nullopt;
+	}
+	if (!a || !b) {
+		return spectate::dequantize(a ? *a : *b);
+	}
+
+	auto f = spectate::dequantize(*a);
+	const auto g = spectate::dequantize(*b);
+	const auto alpha = float((renderTick - a->tick) / double(b->tick - a->tick));
+	const auto lerp = [alpha](vec2 x, vec2 y) { return x + (y - x) * alpha; };
+
+	// saque/ponto teletransporta a bola: não interpola através disso
+	const auto jump = g.ballPos - f.ballPos;
+	if (std::abs(jump.x) + std::abs(jump.y) > 100) {
+		return alpha < 0.5f ? f : g;
+	}
+
+	f.pos[0] = lerp(f.pos[0], g.pos[0]);
+	f.pos[1] = lerp(f.pos[1], g.pos[1]);
+	f.ballPos = lerp(f.ballPos, g.ballPos);
+	f.vel[0] = lerp(f.vel[0], g.vel[0]);
+	f.vel[1] = lerp(f.vel[1], g.vel[1]);
+	f.ballVel = lerp(f.ballVel, g.ballVel);
+	return f;
+}
@@ -0,0 +1,129 @@
+#pragma once
+// transmissão da partida pra espectadores por UDP.
+//
+// o host codifica cada tick uma vez só e manda os mesmos bytes pra todos
+// os inscritos. Posições/velocidades vão quantizadas e em delta contra o
+// último keyframe (não contra o tick anterior), então um pacote perdido
+// não estraga os seguintes. O espectador guarda alguns ticks e desenha
+// um pouco atrás do último recebido, interpolando.
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+#include "SFML/Network/UdpSocket.hpp"
+#include "SFML/Network/IpAddress.hpp"
+#include "match.h"
+#include "spsc_queue.h"
+
+namespace pong
+{
+	namespace spectate
+	{
+		constexpr int keyframe_interval = 30; // ticks
+		constexpr int fields = 15;
+
+		// match_frame em inteiros: posição em 1/8 px, velocidade em 1/64 px/tick
+		struct quantized
+		{
+			std::uint32_t tick = 0;
+			std::int32_t v[fields] = {};
+		};
+
+		quantized quantize(const match_frame& f) noexcept;
+		match_frame dequantize(const quantized& q) noexcept;
+
+		// pacote de estado: keyframe se base == nullptr
+		std::size_t encode(const quantized& q, const quantized* base, void* buf, std::size_t cap) noexcept;
+		// base: o último keyframe recebido; false se o pacote depende de outro
+		bool decode(const void* buf, std::size_t size, const quantized* base, quantized& out, bool& keyframe) noexcept;
+	}
+
+	class broadcaster
+	{
+	public:
+		static constexpr std::size_t max_subscribers = 1024;
+
+		explicit broadcaster(unsigned short port);
+		~broadcaster();
+
+		bool ok() const noexcept { return bound; }
+
+		// main thread, uma vez por tick. Nunca bloqueia
+		void push(const match_frame& frame) noexcept { frames.push(frame); }
+
+		int subscribers() const noexcept { return subscriberCount.load(std::memory_order_relaxed); }
+		std::uint64_t bytesSent() const noexcept { return sentBytes.load(std::memory_order_relaxed); }
+
+	private:
+		struct subscriber
+		{
+			sf::IpAddress addr;
+			unsigned short port;
+			std::chrono::steady_clock::time_point lastSeen;
+		};
+
+		sf::UdpSocket socket;
+		bool bound = false;
+		util::spsc_queue<match_frame, 64> frames;
+		std::vector<subscriber> subs;
+		std::atomic<int> subscriberCount{ 0 };
+		std::atomic<std::uint64_t> sentBytes{ 0 };
+
+		spectate::quantized key, last;
+		bool haveKey = false;
+
+		std::jthread worker;
+
+		void run(std::stop_token stop);
+		void receive();
+		void send(const match_frame& frame);
+	};
+
+	class spectator
+	{
+	public:
+		static constexpr double interp_delay = 3; // ticks atrás do último recebido
+
+		explicit spectator(const std::string& host);
+		~spectator();
+
+		bool ok() const noexcept { return bound; }
+
+		// main thread, uma vez por frame. Frame interpolado, se já tem
+		std::optional<match_frame> update();
+
+		struct stats_t
+		{
+			std::uint64_t packets = 0, lost = 0, waiting = 0;
+			double renderTick = 0;
+			std::uint32_t latestTick = 0;
+		};
+		const stats_t& stats() const noexcept { return st; }
+
+	private:
+		using clock = std::chrono::steady_clock;
+		static constexpr std::size_t buffered = 32;
+
+		sf::UdpSocket socket;
+		sf::IpAddress hostAddr;
+		unsigned short hostPort = 0;
+		bool bound = false;
+
+		spectate::quantized key;
+		bool haveKey = false;
+		std::array<spectate::quantized, buffered> ring; // indexado por tick % buffered
+		std::uint32_t latest = 0;
+		bool haveState = false;
+
+		double renderTick = 0;
+		clock::time_point lastUpdate, lastHello;
+		stats_t st;
+
+		void hello(std::uint8_t type);
+		void receive();
+	};
+}
@@ -0,0 +1,608 @@
+#include <algorithm>
+#include <limits>
+#include <mutex>
+#include <spdlog/spdlog.h>
+#include "columnar.h"
+#include "mpmc_queue.h"
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using namespace std::literals;
+using namespace pong::columnar;
+
+namespace
+{
+	constexpr char magic[4] = { 'S', 'F', 'P', 'C' };
+	constexpr std::uint32_t format_version = 1;
+	constexpr std::size_t header_size = 8;  // magic + versão
+	constexpr std::size_t trailer_size = 16; // offset do rodapé + magic + versão
+
+	enum codec : std::uint32_t { raw, packed };
+
+	// --- codec: delta (xor nos floats), bytes de cada posição juntos, RLE ---
+	//
+	// contadores, ids e ticks viram diferenças pequenas; separando os bytes,
+	// os mais altos ficam quase todos zero e o RLE (PackBits) come isso
+
+	template<class U>
+	constexpr U zigzag(U d) noexcept
+	{
+		using S = std::make_signed_t<U>;
+		return U(d << 1) ^ U(S(d) >> (sizeof(U) * 8 - 1));
+	}
+
+	template<class U>
+	constexpr U unzigzag(U z) noexcept
+	{
+		return U(z >> 1) ^ U(0 - (z & 1));
+	}
+
+	template<class U>
+	void shuffle_delta(const std::byte* in, std::size_t n, bool isFloat, std::byte* out) noexcept
+	{
+		U prev = 0;
+		for (std::size_t i = 0; i < n; i++)
+		{
+			U v;
+			std::memcpy(&v, in + i * sizeof(U), sizeof(U));
+			const U d = isFloat ? U(v ^ prev) : zigzag(U(v - prev));
+			prev = v;
+			for (std::size_t k = 0; k < sizeof(U); k++) {
+				out[k * n + i] = std::byte(d >> (8 * k));
+			}
+		}
+	}
+
+	template<class U>
+	void unshuffle_delta(const std::byte* in, std::size_t n, bool isFloat, std::byte* out) noexcept
+	{
+		U prev = 0;
+		for (std::size_t i = 0; i < n; i++)
+		{
+			U d = 0;
+			for (std::size_t k = 0; k < sizeof(U); k++) {
+				d |= U(std::to_integer<U>(in[k * n + i]) << (8 * k));
+			}
+			const U v = isFloat ? U(d ^ prev) : U(prev + unzigzag(d));
+			prev = v;
+			std::memcpy(out + i * sizeof(U), &v, sizeof(U));
+		}
+	}
+
+	// PackBits: h < 128 = h + 1 bytes copiados; h >= 128 = o próximo byte 257 - h vezes
+	std::size_t rle_pack(const std::byte* in, std::size_t n, std::byte* out) noexcept
+	{
+		std::size_t i = 0, o = 0;
+		while (i < n)
+		{
+			std::size_t run = 1;
+			while (i + run < n && run < 128 && in[i + run] == in[i]) run++;
+
+			if (run >= 3)
+			{
+				out[o++] = std::byte(257 - run);
+				out[o++] = in[i];
+				i += run;
+				continue;
+			}
+
+			// literais até a próxima sequência de 3 iguais
+			std::size_t len = 0;
+			while (i + len < n && len < 128)
+			{
+				if (i + len + 2 < n && in[i + len] == in[i + len + 1] && in[i + len] == in[i + len + 2])
+					break;
+				len++;
+			}
+			out[o++] = std::byte(len - 1);
+			std::memcpy(out + o, in + i, len);
+			o += len;
+			i += len;
+		}
+		return o;
+	}
+
+	bool rle_unpack(const std::byte* in, std::size_t n, std::byte* out, std::size_t outSize) noexcept
+	{
+		std::size_t i = 0, o = 0;
+		while (i < n)
+		{
+			const auto h = std::to_integer<unsigned>(in[i++]);
+			if (h < 128)
+			{
+				const std::size_t len = h + 1;
+				if (i + len > n || o + len > outSize)
+					return false;
+				std::memcpy(out + o, in + i, len);
+				i += len;
+				o += len;
+			}
+			else
+			{
+				const std::size_t len = 257 - h;
+				if (i >= n || o + len > outSize)
+					return false;
+				std::memset(out + o, std::to_integer<int>(in[i++]), len);
+				o += len;
+			}
+		}
+		return o == outSize;
+	}
+
+	template<class T>
+	void add_stats(const std::byte* in, std::size_t n, chunk_info& info) noexcept
+	{
+		double lo = std::numeric_limits<double>::infinity(), hi = -lo, sum = 0;
+		for (std::size_t i = 0; i < n; i++)
+		{
+			T v;
+			std::memcpy(&v, in + i * sizeof(T), sizeof(T));
+			lo = std::min(lo, double(v));
+			hi = std::max(hi, double(v));
+			sum += double(v);
+		}
+		info.min = lo;
+		info.max = hi;
+		info.sum = sum;
+	}
+
+	template<class T>
+	void put_bytes(std::vector<std::byte>& out, const T& value)
+	{
+		const auto* p = reinterpret_cast<const std::byte*>(&value);
+		out.insert(out.end(), p, p + sizeof(T));
+	}
+
+	template<class T>
+	bool get_bytes(const std::byte*& p, const std::byte* end, T& value) noexcept
+	{
+		if (std::size_t(end - p) < sizeof(T))
+			return false;
+		std::memcpy(&value, p, sizeof(T));
+		p += sizeof(T);
+		return true;
+	}
+}
+
+namespace pong::columnar::detail
+{
+	struct column_chunk
+	{
+		std::vector<std::byte> raw, packed;
+		chunk_info info;
+	};
+
+	// group_rows linhas de todas as colunas. Alocado uma vez, volta pra
+	// fila de livres depois de gravado
+	struct group
+	{
+		std::uint32_t rows = 0;
+		column_chunk cols[max_columns];
+		std::vector<std::byte> shuffled;
+
+		group(std::span<const column_type> types)
+		{
+			for (std::size_t c = 0; c < types.size(); c++)
+			{
+				const auto bytes = group_rows * width(types[c]);
+				cols[c].raw.resize(bytes);
+				cols[c].packed.resize(bytes + bytes / 128 + 1); // pior caso do RLE
+			}
+			shuffled.resize(group_rows * 8);
+		}
+
+		void compress(std::span<const column_type> types) noexcept
+		{
+			for (std::size_t c = 0; c < types.size(); c++)
+			{
+				auto& col = cols[c];
+				const auto t = types[c];
+				const auto bytes = rows * width(t);
+				const auto* in = col.raw.data();
+
+				switch (t)
+				{
+				case column_type::i32: add_stats<std::int32_t>(in, rows, col.info); break;
+				case column_type::u32: add_stats<std::uint32_t>(in, rows, col.info); break;
+				case column_type::u64: add_stats<std::uint64_t>(in, rows, col.info); break;
+				case column_type::f32: add_stats<float>(in, rows, col.info); break;
+				case column_type::f64: add_stats<double>(in, rows, col.info); break;
+				}
+
+				const bool isFloat = t == column_type::f32 || t == column_type::f64;
+				if (width(t) == 8) shuffle_delta<std::uint64_t>(in, rows, isFloat, shuffled.data());
+				else shuffle_delta<std::uint32_t>(in, rows, isFloat, shuffled.data());
+
+				const auto size = rle_pack(shuffled.data(), bytes, col.packed.data());
+				col.info.codec = size < bytes ? codec::packed : codec::raw;
+				col.info.size = std::uint32_t(size < bytes ? size : bytes);
+			}
+		}
+	};
+}
+
+// filas e grupos de um writer
+struct pong::columnar::writer::shared
+{
+	// cheia: o appender espera a escrita devolver um grupo
+	static constexpr std::size_t max_groups = 64;
+	using queue_t = util::mpmc_queue<detail::group*, 128>;
+	static_assert(queue_t::capacity() >= max_groups);
+
+	queue_t free, full;
+	std::mutex allocLock;
+	std::vector<std::unique_ptr<detail::group>> all;
+};
+
+pong::columnar::writer::writer() = default;
+
+pong::columnar::writer::~writer()
+{
+	close();
+}
+
+bool pong::columnar::writer::open(const std::filesystem::path& path, std::vector<column> schema)
+{
+	close();
+	if (schema.empty() || schema.size() > max_columns)
+		return false;
+
+	file = std::fopen(path.string().c_str(), "wb");
+	if (!file) {
+		spdlog::error("columnar: failed to open {}", path.string());
+		return false;
+	}
+
+	columns = std::move(schema);
+	for (std::size_t c = 0; c < columns.size(); c++) {
+		types[c] = columns[c].type;
+	}
+
+	failed = false;
+	write_bytes(magic, sizeof(magic));
+	write_bytes(&format_version, sizeof(format_version));
+
+	rowCount = 0;
+	written = header_size;
+	rawBytes = 0;
+	index.clear();
+	groupSizes.clear();
+
+	queues = std::make_unique<shared>();
+	thread = std::jthread([this](std::stop_token stop) { run(stop); });
+	return true;
+}
+
+void pong::columnar::writer::run(std::stop_token stop)
+{
+	detail::group* g;
+	for (;;)
+	{
+		bool any = false;
+		while (queues->full.pop(g)) {
+			write_group(g);
+			any = true;
+		}
+
+		if (!any)
+		{
+			if (stop.stop_requested())
+				break;
+			std::this_thread::sleep_for(1ms);
+		}
+	}
+
+	// o último grupo pode ter entrado entre o pop vazio e o stop: close()
+	// só pede stop depois dos appenders, então esta volta pega todos
+	while (queues->full.pop(g)) {
+		write_group(g);
+	}
+}
+
+void pong::columnar::writer::write_group(detail::group* g)
+{
+	static constexpr std::byte zeros[8] = {};
+
+	for (std::size_t c = 0; c < columns.size(); c++)
+	{
+		auto& col = g->cols[c];
+		col.info.offset = written;
+
+		const auto* data = col.info.codec == codec::packed ? col.packed.data() : col.raw.data();
+		write_bytes(data, col.info.size);
+
+		// pedaços começam alinhados em 8: o reader lê os crus direto do mapeamento
+		const auto pad = (8 - col.info.size % 8) % 8;
+		write_bytes(zeros, pad);
+
+		written += col.info.size + pad;
+		rawBytes += g->rows * width(types[c]);
+		index.push_back(col.info);
+	}
+
+	groupSizes.push_back(g->rows);
+	rowCount += g->rows;
+
+	g->rows = 0;
+	queues->free.push(g);
+}
+
+void pong::columnar::writer::write_bytes(const void* data, std::size_t size) noexcept
+{
+	if (size > 0 && std::fwrite(data, 1, size, file) != size) {
+		failed = true;
+	}
+}
+
+bool pong::columnar::writer::close()
+{
+	if (!file)
+		return true;
+
+	thread.request_stop();
+	thread.join();
+
+	// rodapé: schema, linhas por grupo e o índice dos pedaços
+	std::vector<std::byte> footer;
+	put_bytes(footer, std::uint32_t(columns.size()));
+	put_bytes(footer, std::uint32_t(groupSizes.size()));
+	put_bytes(footer, std::uint64_t(rowCount));
+	for (auto& c : columns)
+	{
+		put_bytes(footer, c.type);
+		put_bytes(footer, std::uint8_t(std::min<std::size_t>(c.name.size(), 255)));
+		footer.insert(footer.end(), reinterpret_cast<const std::byte*>(c.name.data()),
+			reinterpret_cast<const std::byte*>(c.name.data()) + std::min<std::size_t>(c.name.size(), 255));
+	}
+	for (auto n : groupSizes) put_bytes(footer, n);
+	for (auto& info : index) put_bytes(footer, info);
+
+	const std::uint64_t footerAt = written;
+	write_bytes(footer.data(), footer.size());
+	write_bytes(&footerAt, sizeof(footerAt));
+	write_bytes(magic, sizeof(magic));
+	write_bytes(&format_version, sizeof(format_version));
+	written += footer.size() + trailer_size;
+
+	// o fclose também escreve (o que ficou no buffer do stdio)
+	failed |= std::fclose(file) != 0;
+	file = nullptr;
+	queues.reset();
+	return !failed;
+}
+
+
+pong::columnar::writer::appender& pong::columnar::writer::appender::operator=(appender&& o) noexcept
+{
+	if (this != &o)
+	{
+		flush();
+		owner = std::exchange(o.owner, nullptr);
+		current = std::exchange(o.current, nullptr);
+		std::copy(std::begin(o.dest), std::end(o.dest), dest);
+		rows = std::exchange(o.rows, 0);
+	}
+	return *this;
+}
+
+void pong::columnar::writer::appender::acquire() noexcept
+{
+	auto& q = *owner->queues;
+	const std::span<const column_type> types(owner->types, owner->columns.size());
+
+	while (!q.free.pop(current))
+	{
+		{
+			std::scoped_lock _lock_(q.allocLock);
+			if (q.all.size() < shared::max_groups)
+			{
+				current = q.all.emplace_back(std::make_unique<detail::group>(types)).get();
+				break;
+			}
+		}
+		// todos os grupos na fila de escrita: espera o disco
+		std::this_thread::yield();
+	}
+
+	for (std::size_t c = 0; c < types.size(); c++) {
+		dest[c] = current->cols[c].raw.data();
+	}
+	rows = 0;
+}
+
+void pong::columnar::writer::appender::seal() noexcept
+{
+	// comprime aqui, em paralelo com as outras threads; a escrita só grava
+	current->rows = rows;
+	current->compress({ owner->types, owner->columns.size() });
+	owner->queues->full.push(current);
+	current = nullptr;
+	rows = 0;
+}
+
+void pong::columnar::writer::appender::flush() noexcept
+{
+	if (!current)
+		return;
+
+	if (rows > 0) {
+		seal();
+	}
+	else {
+		owner->queues->free.push(current);
+		current = nullptr;
+	}
+}
+
+
+bool pong::columnar::reader::open(const std::filesystem::path& path)
+{
+	close();
+
+#if defined(_WIN32)
+	HANDLE fileHandle = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (fileHandle == INVALID_HANDLE_VALUE)
+		return false;
+	LARGE_INTEGER fileSize;
+	GetFileSizeEx(fileHandle, &fileSize);
+	size = std::uint64_t(fileSize.QuadPart);
+	if (size > 0)
+	{
+		mapping = CreateFileMappingW(fileHandle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		if (mapping) base = static_cast<const std::byte*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+	}
+	CloseHandle(fileHandle);
+#else
+	const int fd = ::open(path.c_str(), O_RDONLY);
+	if (fd < 0)
+		return false;
+	struct stat st;
+	if (fstat(fd, &st) == 0 && st.st_size > 0)
+	{
+		size = std::uint64_t(st.st_size);
+		void* p = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+		if (p != MAP_FAILED) base = static_cast<const std::byte*>(p);
+	}
+	::close(fd);
+#endif
+
+	auto fail = [&](std::string_view what) {
+		spdlog::error("columnar {}: {}", path.string(), what);
+		close();
+		return false;
+	};
+
+	if (!base || size < header_size + trailer_size)
+		return fail("can't map file or file too small");
+
+	std::uint32_t version = 0;
+	std::memcpy(&version, base + 4, sizeof(version));
+	if (std::memcmp(base, magic, sizeof(magic)) != 0 || version != format_version
+		|| std::memcmp(base + size - 8, magic, sizeof(magic)) != 0)
+	{
+		return fail("not a sfPong columnar file (or written by another version, or not closed)");
+	}
+
+	std::uint64_t footerAt = 0;
+	std::memcpy(&footerAt, base + size - trailer_size, sizeof(footerAt));
+	if (footerAt < header_size || footerAt > size - trailer_size)
+		return fail("bad footer offset");
+
+	const std::byte* p = base + footerAt;
+	const std::byte* end = base + size - trailer_size;
+	std::uint32_t ncols = 0, ngroups = 0;
+	if (!get_bytes(p, end, ncols) || !get_bytes(p, end, ngroups) || !get_bytes(p, end, rowCount)
+		|| ncols == 0 || ncols > max_columns)
+	{
+		return fail("bad footer");
+	}
+
+	for (std::uint32_t c = 0; c < ncols; c++)
+	{
+		column col;
+		std::uint8_t len = 0;
+		if (!get_bytes(p, end, col.type) || std::uint8_t(col.type) > std::uint8_t(column_type::f64)
+			|| !get_bytes(p, end, len) || std::size_t(end - p) < len)
+		{
+			return fail("bad column in footer");
+		}
+		col.name.assign(reinterpret_cast<const char*>(p), len);
+		p += len;
+		cols.push_back(std::move(col));
+	}
+
+	groupSizes.resize(ngroups);
+	index.resize(std::size_t(ngroups) * ncols);
+	for (auto& n : groupSizes) {
+		if (!get_bytes(p, end, n) || n > group_rows) return fail("bad group size");
+	}
+	for (auto& info : index)
+	{
+		if (!get_bytes(p, end, info) || info.offset % 8 != 0 || info.offset + info.size > footerAt)
+			return fail("bad chunk index");
+	}
+	return true;
+}
+
+void pong::columnar::reader::close() noexcept
+{
+	if (base)
+	{
+#if defined(_WIN32)
+		UnmapViewOfFile(base);
+#else
+		munmap(const_cast<std::byte*>(base), size);
+#endif
+	}
+#if defined(_WIN32)
+	if (mapping) CloseHandle(mapping);
+#endif
+	base = nullptr;
+	mapping = nullptr;
+	size = 0;
+	cols.clear();
+	index.clear();
+	groupSizes.clear();
+	rowCount = 0;
+}
+
+int pong::columnar::reader::find(std::string_view name) const noexcept
+{
+	for (std::size_t c = 0; c < cols.size(); c++)
+	{
+		if (cols[c].name == name)
+			return int(c);
+	}
+	return -1;
+}
+
+pong::columnar::column_stats pong::columnar::reader::stats(std::size_t col) const noexcept
+{
+	column_stats s;
+	if (col >= cols.size() || groupSizes.empty())
+		return s;
+
+	s.min = std::numeric_limits<double>::infinity();
+	s.max = -s.min;
+	for (std::size_t g = 0; g < groupSizes.size(); g++)
+	{
+		auto& info = index[g * cols.size() + col];
+		s.count += groupSizes[g];
+		s.min = std::min(s.min, info.min);
+		s.max = std::max(s.max, info.max);
+		s.sum += info.sum;
+	}
+	return s;
+}
+
+const std::byte* pong::columnar::reader::chunk(std::size_t group, std::size_t col)
+{
+	const auto& info = index[group * cols.size() + col];
+	const auto t = cols[col].type;
+	const std::size_t n = groupSizes[group];
+	const std::size_t bytes = n * width(t);
+
+	if (info.codec == codec::raw)
+		return info.size == bytes ? base + info.offset : nullptr;
+
+	unpacked.resize(bytes);
+	auto& decoded = scratch[col];
+	decoded.resize((bytes + 7) / 8);
+	if (!rle_unpack(base + info.offset, info.size, unpacked.data(), bytes))
+		return nullptr;
+
+	auto* out = reinterpret_cast<std::byte*>(decoded.data());
+	const bool isFloat = t == column_type::f32 || t == column_type::f64;
+	if (width(t) == 8) unshuffle_delta<std::uint64_t>(unpacked.data(), n, isFloat, out);
+	else unshuffle_delta<std::uint32_t>(unpacked.data(), n, isFloat, out);
+	return out;
+}
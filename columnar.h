@@ -0,0 +1,249 @@
+#pragma once
+// tabela colunar em arquivo, pra resultados grandes (uma linha por ponto,
+// por rebatida...). Colunas de largura fixa, guardadas em grupos de
+// group_rows linhas; cada pedaço de coluna é comprimido sozinho e o rodapé
+// tem o índice (offset, tamanho, min, max, soma) de todos eles.
+//
+// Escrita: cada thread tem o seu appender, que enche um grupo e o comprime
+// na própria thread; a thread de escrita só grava os bytes prontos. A ordem
+// dos grupos no arquivo depende das threads, a das linhas dentro de um
+// grupo não. Leitura: o arquivo inteiro mapeado em memória; scan() passa
+// uma coluna pedaço a pedaço, sem tocar nas outras
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <memory>
+#include <span>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace pong::columnar
+{
+	enum class column_type : std::uint8_t { i32, u32, u64, f32, f64 };
+
+	constexpr std::size_t width(column_type t) noexcept
+	{
+		return t == column_type::u64 || t == column_type::f64 ? 8 : 4;
+	}
+
+	template<class T>
+	constexpr column_type type_of() noexcept
+	{
+		if constexpr (std::is_same_v<T, std::int32_t>) return column_type::i32;
+		else if constexpr (std::is_same_v<T, std::uint32_t>) return column_type::u32;
+		else if constexpr (std::is_same_v<T, std::uint64_t>) return column_type::u64;
+		else if constexpr (std::is_same_v<T, float>) return column_type::f32;
+		else if constexpr (std::is_same_v<T, double>) return column_type::f64;
+		else static_assert(!sizeof(T), "columnar: tipo de coluna não suportado");
+	}
+
+	struct column
+	{
+		std::string name;
+		column_type type;
+	};
+
+	constexpr std::size_t max_columns = 16;
+	constexpr std::uint32_t group_rows = 16384;
+
+	// um pedaço de coluna no arquivo; min/max/soma dos valores, pra agregar
+	// sem descomprimir
+	struct chunk_info
+	{
+		std::uint64_t offset;
+		std::uint32_t size;  // bytes no arquivo
+		std::uint32_t codec; // 0: cru, 1: delta + bytes separados + RLE
+		double min, max, sum;
+	};
+	static_assert(std::is_trivially_copyable_v<chunk_info>);
+
+	namespace detail { struct group; }
+
+	class writer
+	{
+	public:
+		writer();
+		writer(const writer&) = delete;
+		~writer();
+
+		bool open(const std::filesystem::path& file, std::vector<column> schema);
+		// os appenders já precisam ter sido destruídos (ou flush()).
+		// false se alguma escrita falhou (disco cheio...): o arquivo não presta
+		bool close();
+		bool is_open() const noexcept { return file != nullptr; }
+
+		std::uint64_t rows() const noexcept { return rowCount.load(std::memory_order_relaxed); }
+		// bytes no arquivo até agora e o que seria sem compressão
+		std::uint64_t bytes() const noexcept { return written.load(std::memory_order_relaxed); }
+		std::uint64_t raw_bytes() const noexcept { return rawBytes.load(std::memory_order_relaxed); }
+
+		// linhas de uma thread só; não copiável, um por thread
+		class appender
+		{
+		public:
+			appender() = default;
+			explicit appender(writer& w) noexcept : owner(&w) {}
+			appender(appender&& o) noexcept { *this = std::move(o); }
+			appender& operator=(appender&& o) noexcept;
+			~appender() { flush(); }
+
+			// um valor por coluna, na ordem do schema; convertido pro tipo dela
+			template<class... Args>
+			void append(const Args&... values) noexcept
+			{
+				static_assert(sizeof...(Args) > 0 && sizeof...(Args) <= max_columns);
+				if (!owner)
+					return;
+				// a mais passaria de dest[]; a menos deixaria lixo de um grupo reciclado
+				assert(sizeof...(Args) == owner->columns.size());
+				if (sizeof...(Args) != owner->columns.size())
+					return;
+				if (!current)
+					acquire();
+
+				std::size_t c = 0;
+				(put(c++, values), ...);
+				if (++rows == group_rows)
+					seal();
+			}
+
+			// manda o grupo atual, mesmo incompleto
+			void flush() noexcept;
+
+		private:
+			writer* owner = nullptr;
+			detail::group* current = nullptr;
+			std::byte* dest[max_columns] = {};
+			std::uint32_t rows = 0;
+
+			template<class T>
+			void put(std::size_t c, const T& value) noexcept
+			{
+				auto store = [&](auto v) { std::memcpy(dest[c] + rows * sizeof(v), &v, sizeof(v)); };
+				switch (owner->types[c])
+				{
+				case column_type::i32: store(std::int32_t(value)); break;
+				case column_type::u32: store(std::uint32_t(value)); break;
+				case column_type::u64: store(std::uint64_t(value)); break;
+				case column_type::f32: store(float(value)); break;
+				case column_type::f64: store(double(value)); break;
+				}
+			}
+
+			void acquire() noexcept;
+			void seal() noexcept;
+		};
+
+		appender make_appender() noexcept { return appender(*this); }
+
+	private:
+		struct shared;
+
+		std::vector<column> columns;
+		column_type types[max_columns] = {};
+		std::FILE* file = nullptr;
+		std::unique_ptr<shared> queues;
+		std::jthread thread;
+		std::atomic<std::uint64_t> rowCount{ 0 }, written{ 0 }, rawBytes{ 0 };
+
+		// estado da thread de escrita
+		std::vector<chunk_info> index;
+		std::vector<std::uint32_t> groupSizes;
+		bool failed = false; // algum fwrite não escreveu tudo
+
+		void run(std::stop_token stop);
+		void write_group(detail::group* g);
+		void write_bytes(const void* data, std::size_t size) noexcept;
+	};
+
+	// resumo de uma coluna, só com o rodapé
+	struct column_stats
+	{
+		std::uint64_t count = 0;
+		double min = 0, max = 0, sum = 0;
+	};
+
+	// arquivo mapeado em memória; um reader por thread (scan usa buffers internos)
+	class reader
+	{
+	public:
+		reader() = default;
+		reader(const reader&) = delete;
+		~reader() { close(); }
+
+		bool open(const std::filesystem::path& file);
+		void close() noexcept;
+
+		std::span<const column> columns() const noexcept { return cols; }
+		std::uint64_t rows() const noexcept { return rowCount; }
+		std::size_t groups() const noexcept { return groupSizes.size(); }
+		std::uint64_t file_size() const noexcept { return size; }
+
+		// índice da coluna ou -1
+		int find(std::string_view name) const noexcept;
+		column_stats stats(std::size_t col) const noexcept;
+
+		// f(std::span<const T>) pra cada grupo, em ordem; T precisa ser o tipo
+		// da coluna. Pedaços sem compressão vêm direto do mapeamento
+		template<class T, class F>
+		bool scan(std::size_t col, F&& f)
+		{
+			if (col >= cols.size() || cols[col].type != type_of<T>())
+				return false;
+
+			for (std::size_t g = 0; g < groupSizes.size(); g++)
+			{
+				const auto* data = chunk(g, col);
+				if (!data)
+					return false;
+				f(std::span<const T>(reinterpret_cast<const T*>(data), groupSizes[g]));
+			}
+			return true;
+		}
+
+		// duas colunas lado a lado, f(span<const A>, span<const B>) com as
+		// mesmas linhas: agrupar uma pela outra
+		template<class A, class B, class F>
+		bool scan(std::size_t colA, std::size_t colB, F&& f)
+		{
+			if (colA >= cols.size() || colB >= cols.size() || colA == colB
+				|| cols[colA].type != type_of<A>() || cols[colB].type != type_of<B>())
+			{
+				return false;
+			}
+
+			for (std::size_t g = 0; g < groupSizes.size(); g++)
+			{
+				const auto* a = chunk(g, colA);
+				const auto* b = chunk(g, colB);
+				if (!a || !b)
+					return false;
+				f(std::span<const A>(reinterpret_cast<const A*>(a), groupSizes[g]),
+					std::span<const B>(reinterpret_cast<const B*>(b), groupSizes[g]));
+			}
+			return true;
+		}
+
+	private:
+		std::vector<column> cols;
+		std::vector<chunk_info> index; // grupo * colunas + coluna
+		std::vector<std::uint32_t> groupSizes;
+		std::uint64_t rowCount = 0;
+
+		const std::byte* base = nullptr;
+		std::uint64_t size = 0;
+		void* mapping = nullptr; // handle do Windows
+
+		std::vector<std::byte> unpacked; // antes de desfazer o delta
+		std::vector<std::uint64_t> scratch[max_columns]; // pedaço descomprimido de cada coluna, alinhado pra 8
+
+		const std::byte* chunk(std::size_t group, std::size_t col);
+	};
+}
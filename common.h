@@ -27,7 +27,8 @@ namespace files
 {
     constexpr auto
         sans_tff = "support/liberation-sans.ttf",
-        mono_tff = "support/liberation-mono.ttf"
+        mono_tff = "support/liberation-mono.ttf",
+        cache_dir = "cache"
         ;
 }
     // verso do jogo
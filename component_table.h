@@ -0,0 +1,69 @@
+#pragma once
+#include <cassert>
+#include <cstddef>
+#include <span>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+namespace util
+{
+    // entidades guardadas por componente: um vector contíguo por tipo,
+    // entidade = índice. Os sistemas pegam só as colunas que usam e andam
+    // nelas em loop reto, sem virtual nem ponteiro por entidade.
+    // Cada componente precisa ser de um tipo diferente (é a chave da coluna).
+    // remove() troca com a última: índices não são estáveis
+    template<class... Components>
+    class component_table
+    {
+    public:
+        std::size_t size() const noexcept { return count; }
+        bool empty() const noexcept { return count == 0; }
+
+        void reserve(std::size_t n)
+        {
+            (column<Components>().reserve(n), ...);
+        }
+
+        std::size_t add(Components... values)
+        {
+            (column<Components>().push_back(std::move(values)), ...);
+            return count++;
+        }
+
+        void remove(std::size_t i)
+        {
+            assert(i < count);
+            count--;
+            (swap_pop(column<Components>(), i), ...);
+        }
+
+        void clear() noexcept
+        {
+            (column<Components>().clear(), ...);
+            count = 0;
+        }
+
+        template<class C>
+        std::span<C> get() noexcept { return column<C>(); }
+
+        template<class C>
+        std::span<const C> get() const noexcept { return std::get<std::vector<C>>(columns); }
+
+    private:
+        std::tuple<std::vector<Components>...> columns;
+        std::size_t count = 0;
+
+        template<class C>
+        std::vector<C>& column() noexcept { return std::get<std::vector<C>>(columns); }
+
+        template<class C>
+        static void swap_pop(std::vector<C>& v, std::size_t i)
+        {
+            if (i != v.size() - 1) {
+                v[i] = std::move(v.back());
+            }
+            v.pop_back();
+        }
+    };
+}
@@ -0,0 +1,190 @@
+#include "font_cache.h"
+#include "hash.h"
+#include "common.h"
+#include "imgui_inc.h"
+
+#include <fstream>
+#include <vector>
+#include <cstring>
+#include <fmt/format.h>
+
+namespace fs = std::filesystem;
+
+namespace
+{
+	constexpr char magic[4] = { 'S', 'F', 'P', 'A' };
+	constexpr std::uint32_t format_version = 1;
+
+	struct header
+	{
+		char magic[4];
+		std::uint32_t version;
+		std::uint32_t imgui_version;
+		std::uint32_t font_count;
+		std::uint64_t key;
+		std::int32_t tex_width, tex_height;
+		float white_u, white_v;
+	};
+
+	struct font_header
+	{
+		float size, ascent, descent;
+		std::uint32_t fallback_char;
+		std::uint32_t glyph_count;
+	};
+
+	struct glyph_rec
+	{
+		std::uint32_t codepoint;
+		float advance_x;
+		float x0, y0, x1, y1;
+		float u0, v0, u1, v1;
+	};
+
+	template<class T>
+	bool read_pod(std::istream& is, T& value) {
+		return bool(is.read(reinterpret_cast<char*>(&value), sizeof(T)));
+	}
+
+	template<class T>
+	void write_pod(std::ostream& os, const T& value) {
+		os.write(reinterpret_cast<const char*>(&value), sizeof(T));
+	}
+}
+
+std::uint64_t pong::font_cache::make_key(std::span<const font_desc> fonts)
+{
+	auto h = util::fnv1a(format_version);
+	h = util::fnv1a(IMGUI_VERSION_NUM, h);
+
+	std::vector<char> buffer;
+	for (auto& f : fonts)
+	{
+		std::ifstream file(f.path, std::ios::binary | std::ios::ate);
+		if (!file)
+			return 0;
+
+		buffer.resize(size_t(file.tellg()));
+		file.seekg(0);
+		file.read(buffer.data(), buffer.size());
+
+		h = util::fnv1a(buffer.data(), buffer.size(), h);
+		h = util::fnv1a(f.size, h);
+		for (auto* r = f.ranges; r && *r; r++) {
+			h = util::fnv1a(*r, h);
+		}
+	}
+
+	return h;
+}
+
+fs::path pong::font_cache::file_for(std::uint64_t key)
+{
+	return fs::path(files::cache_dir) / fmt::format("imgui-atlas-{:016x}.bin", key);
+}
+
+bool pong::font_cache::load(const fs::path& file, std::uint64_t key, ImFontAtlas& atlas)
+{
+	std::ifstream is(file, std::ios::binary);
+	header hdr;
+	if (!is || !read_pod(is, hdr))
+		return false;
+
+	if (std::memcmp(hdr.magic, magic, sizeof(magic)) != 0
+		|| hdr.version != format_version
+		|| hdr.imgui_version != IMGUI_VERSION_NUM
+		|| hdr.key != key
+		|| hdr.tex_width <= 0 || hdr.tex_height <= 0)
+	{
+		return false;
+	}
+
+	const auto pixelCount = size_t(hdr.tex_width) * hdr.tex_height;
+	auto* pixels = static_cast<unsigned char*>(IM_ALLOC(pixelCount));
+	if (!is.read(reinterpret_cast<char*>(pixels), pixelCount)) {
+		IM_FREE(pixels);
+		return false;
+	}
+
+	// AddGlyph() usa o tamanho da textura
+	atlas.TexWidth = hdr.tex_width;
+	atlas.TexHeight = hdr.tex_height;
+	atlas.TexUvScale = ImVec2(1.0f / hdr.tex_width, 1.0f / hdr.tex_height);
+	atlas.TexUvWhitePixel = ImVec2(hdr.white_u, hdr.white_v);
+	atlas.TexPixelsAlpha8 = pixels;
+
+	for (std::uint32_t i = 0; i < hdr.font_count; i++)
+	{
+		font_header fh;
+		if (!read_pod(is, fh)) {
+			atlas.Clear();
+			return false;
+		}
+
+		auto* font = IM_NEW(ImFont)();
+		font->ContainerAtlas = &atlas;
+		font->FontSize = fh.size;
+		font->Ascent = fh.ascent;
+		font->Descent = fh.descent;
+		font->FallbackChar = ImWchar(fh.fallback_char);
+		atlas.Fonts.push_back(font);
+
+		for (std::uint32_t g = 0; g < fh.glyph_count; g++)
+		{
+			glyph_rec r;
+			if (!read_pod(is, r)) {
+				atlas.Clear();
+				return false;
+			}
+			font->AddGlyph(nullptr, ImWchar(r.codepoint), r.x0, r.y0, r.x1, r.y1, r.u0, r.v0, r.u1, r.v1, r.advance_x);
+		}
+		font->BuildLookupTable();
+	}
+
+	atlas.TexReady = true;
+	return true;
+}
+
+bool pong::font_cache::save(const fs::path& file, std::uint64_t key, ImFontAtlas& atlas)
+{
+	unsigned char* pixels;
+	int width, height;
+	atlas.GetTexDataAsAlpha8(&pixels, &width, &height);
+	if (!pixels)
+		return false;
+
+	std::error_code ec;
+	fs::create_directories(file.parent_path(), ec);
+
+	std::ofstream os(file, std::ios::binary | std::ios::trunc);
+	if (!os)
+		return false;
+
+	header hdr{};
+	std::memcpy(hdr.magic, magic, sizeof(magic));
+	hdr.version = format_version;
+	hdr.imgui_version = IMGUI_VERSION_NUM;
+	hdr.font_count = atlas.Fonts.Size;
+	hdr.key = key;
+	hdr.tex_width = width;
+	hdr.tex_height = height;
+	hdr.white_u = atlas.TexUvWhitePixel.x;
+	hdr.white_v = atlas.TexUvWhitePixel.y;
+
+	write_pod(os, hdr);
+	os.write(reinterpret_cast<const char*>(pixels), size_t(width) * height);
+
+	for (const ImFont* font : atlas.Fonts)
+	{
+		font_header fh{ font->FontSize, font->Ascent, font->Descent, font->FallbackChar, std::uint32_t(font->Glyphs.Size) };
+		write_pod(os, fh);
+
+		for (auto& g : font->Glyphs)
+		{
+			glyph_rec r{ g.Codepoint, g.AdvanceX, g.X0, g.Y0, g.X1, g.Y1, g.U0, g.V0, g.U1, g.V1 };
+			write_pod(os, r);
+		}
+	}
+
+	return bool(os);
+}
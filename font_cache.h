@@ -0,0 +1,26 @@
+#pragma once
+#include <cstdint>
+#include <filesystem>
+#include <span>
+#include "imgui_inc.h" // ImWchar muda com IMGUI_USE_WCHAR32
+
+// cache em disco do atlas de fontes do ImGui já rasterizado
+namespace pong::font_cache
+{
+	struct font_desc
+	{
+		const char* path;
+		float size;
+		const ImWchar* ranges;
+	};
+
+	// chave: hash do conteúdo de cada ttf, tamanho, glyph ranges e versão do ImGui
+	std::uint64_t make_key(std::span<const font_desc> fonts);
+
+	std::filesystem::path file_for(std::uint64_t key);
+
+	// restaura fontes e textura em `atlas` (vazio), na ordem salva
+	bool load(const std::filesystem::path& file, std::uint64_t key, ImFontAtlas& atlas);
+	// `atlas` precisa estar rasterizado
+	bool save(const std::filesystem::path& file, std::uint64_t key, ImFontAtlas& atlas);
+}
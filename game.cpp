@@ -1,7 +1,8 @@
 #include <string>
 #include <algorithm>
-#include <random>
+#include <cmath>
 #include <filesystem>
+#include <future>
 #include <fmt/format.h>
 #include <imgui.h>
 #include <imgui-SFML.h>
@@ -11,6 +12,9 @@
 #include "menu.h"
 #include "gvar.h"
 #include "convert.h"
+#include "startup.h"
+#include "binlog.h"
+#include "telemetry.h"
 
 const char pong::version[] = "0.9.0";
 
@@ -18,36 +22,23 @@ using namespace std::literals;
 
 namespace
 {
-	auto rnd_eng = std::default_random_engine(1337);
+	// um stream por thread: nada compartilhado, e a sequência de cada
+	// thread não depende do que as outras sortearam
+	thread_local auto rnd = pong::rng_stream(pong::squares::key(1337), 0);
 }
 
 
 int pong::random_num(int min, int max)
 {
-	auto dist = std::uniform_int_distribution(min, max);
-	return dist(rnd_eng);
+	return rnd.range(min, max);
 }
 
 bool pong::coin_flip()
 {
-	static std::bernoulli_distribution dist;
-	return dist(rnd_eng);
+	return rnd.coin();
 }
 
 
-bool pong::collision(const sf::Shape &a, const sf::Shape &b)
-{
-	return a.getGlobalBounds().intersects(b.getGlobalBounds());
-}
-bool pong::collision(const sf::Shape& a, const rect& b)
-{
-	return a.getGlobalBounds().intersects(b);
-}
-bool pong::collision(const rect& a, const rect& b)
-{
-	return a.intersects(b);
-}
-
 void pong::constrain_pos(pos& p)
 {
 	using namespace gvar;
@@ -59,24 +50,24 @@ void pong::constrain_pos(pos& p)
 }
 
 
-pong::player_t::player_t(playerid pid) 
-	: id(pid), shape({gvar::paddle_width, gvar::paddle_height})
+void pong::match_stats::sample(const match_frame& frame) noexcept
 {
-	shape.setOrigin({ 0, gvar::paddle_height / 2 });
-	//const sf::Int32 lightgray = 0x45 << 24 | 0x45 << 16 | 0x45 << 8 | 127;
-	shape.setOutlineColor(sf::Color::Black);
-	shape.setOutlineThickness(1.5f);
+	ballSpeed.push(std::hypot(frame.ballVel.x, frame.ballVel.y));
+	p1Speed.push(frame.vel[0].y);
+	p2Speed.push(frame.vel[1].y);
 }
 
-pong::ball_t::ball_t() : shape(gvar::ball_radius)
+void pong::match_stats::point(int rally) noexcept
 {
-	shape.setOrigin(gvar::ball_radius, gvar::ball_radius);
-	shape.setFillColor(sf::Color::Red);
+	rallies.push(float(rally));
 }
 
-pong::background::background(size2d area)
+pong::background::background(size2d area, std::shared_ptr<const arena> map)
 {
 	size(area);
+	if (map) {
+		set_arena(std::move(map));
+	}
 
 	// init net
 	// build alongside the X axis
@@ -115,12 +106,16 @@ pong::background::background(size2d area)
 	// nessa ordem
 	net.transform.translate(mySize.x / 2, 20).rotate(90);
 
-	score.font.loadFromFile(files::mono_tff);
 	score.text.setPosition(mySize.x / 2 - 100, borderSize.y);
 	score.text.setCharacterSize(55);
 	score.text.setFont(score.font);
 }
 
+bool pong::background::load_font(const char* path)
+{
+	return score.font.loadFromFile(path);
+}
+
 void pong::background::update_score(int p1, int p2)
 {
 	score.text.setString(fmt::format("{}    {}", p1, p2));
@@ -142,6 +137,38 @@ void pong::background::size(size2d value)
 	bottom.setSize(borderSize);
 	bottom.setOrigin(origin);
 	bottom.setPosition(mySize.x / 2, mySize.y - 6);
+
+	myArena = arena::standard(value);
+	solids.clear();
+}
+
+void pong::background::set_arena(std::shared_ptr<const arena> value)
+{
+	myArena = std::move(value);
+
+	for (auto [shape, r] : { std::pair{ &top, myArena->top }, std::pair{ &bottom, myArena->bottom } })
+	{
+		shape->setOrigin(0, 0);
+		shape->setSize({ r.width, r.height });
+		shape->setPosition(r.left, r.top);
+	}
+
+	auto quad = [this](const rect& r, sf::Color color) {
+		const sf::Vertex c[4] = {
+			{ { r.left, r.top }, color }, { { r.left + r.width, r.top }, color },
+			{ { r.left + r.width, r.top + r.height }, color }, { { r.left, r.top + r.height }, color },
+		};
+		for (int i : { 0, 1, 2, 0, 2, 3 }) solids.append(c[i]);
+	};
+
+	// walls[0..1] são top e bottom, já desenhadas pelas shapes
+	solids.clear();
+	for (std::size_t i = 2; i < myArena->walls.size(); i++) {
+		quad(myArena->walls[i], top.getFillColor());
+	}
+	for (auto& r : myArena->obstacles) {
+		quad(r, sf::Color(170, 170, 170));
+	}
 }
 
 void pong::background::draw(sf::RenderTarget& target, sf::RenderStates states) const
@@ -152,16 +179,13 @@ void pong::background::draw(sf::RenderTarget& target, sf::RenderStates states) c
 	states.transform = sf::Transform::Identity * getTransform();
 	target.draw(top, states);
 	target.draw(bottom, states);
+	target.draw(solids, states);
 	target.draw(score.text, states);
 }
 
-bool pong::background::border_collision(const rect& bounds) const
+pong::court_t pong::background::court() const
 {
-	rect R[] = {
-		getTransform().transformRect(top.getGlobalBounds()),
-		getTransform().transformRect(bottom.getGlobalBounds())
-	};
-	return bounds.intersects(R[0]) or bounds.intersects(R[1]);
+	return court_t::from(myArena);
 }
 
 pong::point pong::background::getPoint(size_t i) const
@@ -178,12 +202,39 @@ pong::point pong::background::getPoint(size_t i) const
 
 
 pong::game::game(arguments_t params_)
-	: bg({gvar::playarea_width, gvar::playarea_height})
+	: bg(startup::timed("background", [&params_] {
+		// sem o arquivo: a quadra de sempre
+		auto map = std::filesystem::exists(params_.arenaFile) ? arena::load(params_.arenaFile) : nullptr;
+		return background({ gvar::playarea_width, gvar::playarea_height }, std::move(map));
+	}))
+	, sim(bg.court(), 1337, physics_profile::load_or_builtin(params_.gutsFile))
 	, params(params_)
 	, menu(*this, 21)
 {
+	// views com as medidas dos corpos da partida; a posição vem do frame
+	const auto& guts = sim.guts();
+	for (auto& view : paddleView)
+	{
+		view.setSize({ guts.paddle_width, guts.paddle_height });
+		view.setOrigin({ 0, guts.paddle_height / 2 });
+		view.setOutlineColor(sf::Color::Black);
+		view.setOutlineThickness(gvar::paddle_outline);
+	}
+	ballView.setRadius(guts.ball_radius);
+	ballView.setOrigin(guts.ball_radius, guts.ball_radius);
+	ballView.setFillColor(sf::Color::Red);
+	syncFrame(sim.frame());
+
+	// fontes carregam em paralelo com config e criação da janela
+	auto fontTask = std::async(std::launch::async, [this] {
+		startup::scoped_phase _p_("background.load_font");
+		return bg.load_font(files::mono_tff);
+	});
+	menu.prefetch();
+
 	try
 	{
+		startup::scoped_phase _p_("game_settings.load_file");
 		settings.load_file(params.configFile);
 	}
 	catch (std::exception& e)
@@ -193,12 +244,16 @@ pong::game::game(arguments_t params_)
 
 	try
 	{
-		auto vidmode = sf::VideoMode{
-			settings.resolution.x,
-			settings.resolution.y
-		};
-		window.create(vidmode, "Sf Pong!");
-		window.setFramerateLimit(60u);
+		{
+			startup::scoped_phase _p_("window.create");
+			createWindow();
+		}
+
+		// frame mínimo enquanto os assets terminam de carregar
+		window.clear();
+		window.display();
+		startup::mark("first_frame");
+		spdlog::info("first frame: {:.1f} ms", startup::elapsed_ms());
 	}
 	catch (std::exception& e)
 	{
@@ -209,33 +264,129 @@ pong::game::game(arguments_t params_)
 	changeMode(gamemode::singleplayer);
 	reset();
 
-	menu.init();
+	{
+		startup::scoped_phase _p_("wait_assets");
+		if (!fontTask.get()) {
+			spdlog::error("failed to load font {}", files::mono_tff);
+		}
+	}
+
+	if (params.netPort)
+	{
+		// os dois lados começam do mesmo estado; depois disso só os
+		// inputs passam pela rede
+		changeMode(gamemode::multiplayer);
+		setPaused(false);
+
+		netSession = std::make_unique<netplay>(netplay_config{
+			std::uint16_t(params.netPort), params.netPeer,
+			params.netSide == 2 ? playerid::two : playerid::one,
+			params.netLink
+		});
+		if (!netSession->ok()) {
+			netSession.reset();
+		}
+		else if (params.threadedSim) {
+			spdlog::warn("netplay runs the simulation inline, ignoring --threaded");
+		}
+	}
+
+	if (!params.spectate.empty() && !netSession)
+	{
+		// a partida é de outro: o sim local fica parado
+		watcher = std::make_unique<spectator>(params.spectate);
+		if (!watcher->ok()) {
+			watcher.reset();
+		}
+		else setPaused(false);
+	}
+	else if (params.broadcastPort)
+	{
+		caster = std::make_unique<broadcaster>(std::uint16_t(params.broadcastPort));
+		if (!caster->ok()) {
+			caster.reset();
+		}
+	}
+
+	if (params.multiball > 0)
+	{
+		if (netSession || watcher || params.threadedSim) {
+			spdlog::warn("multiball only works with the inline simulation, ignoring it");
+		}
+		else
+		{
+			const auto area = bg.innerBounds();
+			const auto n = std::size_t(params.multiball);
+			balls = std::make_unique<ball_field>(bg.court(), area, n,
+				ball_field::radius_for(area, n, sim.guts().ball_radius), 1, sim.guts());
+			balls->spawn(n);
+			createBallSprite();
+			syncBalls();
+			spdlog::info("multiball: {} balls, radius {:.1f}", n, balls->radius());
+		}
+	}
+
+	if (params.players > 2 || params.partyBalls > 1)
+	{
+		if (netSession || watcher || balls || params.threadedSim) {
+			spdlog::warn("party mode only works with the inline simulation, ignoring it");
+		}
+		else
+		{
+			party = std::make_unique<party_match>(bg.court(), params.players, params.partyBalls, 1337, sim.guts());
+			createBallSprite();
+			syncParty();
+			spdlog::info("party mode: {} players, {} balls", party->players_count(), party->balls().size());
+		}
+	}
+
+	if (params.particles > 0) {
+		fx = std::make_unique<particle_system>(std::size_t(params.particles));
+	}
+
+	runAhead = std::clamp(params.runAhead, 0, max_run_ahead);
+	if (runAhead && (netSession || watcher || balls || party || params.threadedSim)) {
+		spdlog::warn("run-ahead only works with the inline simulation, ignoring it");
+		runAhead = 0;
+	}
+
+	// daqui pra frente a main thread só fala com sim por mensagens
+	if (params.threadedSim && !netSession && !watcher) {
+		simThread = std::make_unique<sim_thread>(sim, gvar::tick_rate, params.simCpu);
+		spdlog::info("simulation thread: {} Hz, cpu {}", gvar::tick_rate, params.simCpu);
+	}
 }
 
 pong::game::~game()
 {
+	simThread.reset();
+	caster.reset();
 	spdlog::info("Tchau! ;D");
 	settings.save_file(params.configFile);
 }
 
 void pong::game::changeMode(gamemode m) noexcept
 {
-	switch (m)
+	mode = m;
+	send({ sim_message::mode, std::uint8_t(m) });
+
+	if (party)
 	{
-	default:
-	case pong::gamemode::singleplayer:
-		player1.ai = false;
-		player2.ai = true;
-		break;
-	case pong::gamemode::multiplayer:
-		player1.ai = player2.ai = false;
-		break;
-	case pong::gamemode::aitest:
-		player1.ai = player2.ai = true;
-		break;
+		// jogadores 1 e 2 usam os controles de sempre, o resto é IA
+		using enum gamemode;
+		party->set_humans(m == singleplayer ? 1 : m == multiplayer ? 2 : 0);
 	}
+}
 
-	mode = m;
+void pong::game::setPaused(bool value) noexcept
+{
+	if (paused != value) {
+		telemetry::emit(value ? telemetry::event_type::pause : telemetry::event_type::resume);
+		// pausado a main thread pode dormir em waitEvent(): não espera o tick
+		telemetry::flush();
+	}
+	paused = value;
+	send({ value ? sim_message::pause : sim_message::resume });
 }
 
 
@@ -253,12 +404,17 @@ void pong::game::processEvent(sf::Event& event)
 		switch (event.key.code)
 		{
 		case sf::Keyboard::F1:
-			player1.ai = !player1.ai;
-			spdlog::debug("DEV. Player1 Ai = {}", player1.ai);
+			send({ sim_message::toggle_ai, std::uint8_t(playerid::one) });
 			break;
 		case sf::Keyboard::F2:
-			player2.ai = !player2.ai;
-			spdlog::debug("DEV. Player2 Ai = {}", player2.ai);
+			send({ sim_message::toggle_ai, std::uint8_t(playerid::two) });
+			break;
+		case sf::Keyboard::F3:
+			// enche o pool, pra medir
+			if (fx) {
+				fx->emit({ .pos = { gvar::playarea_width / 2, gvar::playarea_height / 2 }, .speedMax = 600,
+					.lifeMin = 1, .lifeMax = 3 }, int(fx->capacity()));
+			}
 			break;
 		}
 
@@ -277,16 +433,16 @@ void pong::game::processEvent(sf::Event& event)
 			switch (event.key.code)
 			{
 			case Keyboard::Enter:
-				if (waiting_to_serve()) {
-					serve(serveDir);
-				}
+				serveRequest = true;
 				break;
 			case Keyboard::Escape:
-				paused = !paused;
+				setPaused(!paused);
 				// imgui deve capturar input só com o jogo pausado
-				auto& io = ImGui::GetIO();
-				io.WantCaptureKeyboard = paused;
-				io.WantCaptureMouse = paused;
+				if (menu.ready()) {
+					auto& io = ImGui::GetIO();
+					io.WantCaptureKeyboard = paused;
+					io.WantCaptureMouse = paused;
+				}
 				break;
 			}
 		} break;
@@ -294,289 +450,500 @@ void pong::game::processEvent(sf::Event& event)
 	}
 }
 
-bool pong::game::waiting_to_serve() const noexcept
+void pong::game::send(const sim_message& msg)
 {
-	return !paused
-		&& ball.velocity == vec2()
-		&& ball.shape.getPosition() == point(gvar::playarea_width / 2, gvar::playarea_height / 2);
+	if (netSession) {
+		// a partida é dos dois lados, comandos locais desincronizariam
+		spdlog::debug("netplay: ignoring sim message {}", int(msg.kind));
+	}
+	else if (watcher) {
+		spdlog::debug("spectate: ignoring sim message {}", int(msg.kind));
+	}
+	else if (!simThread) {
+		sim.apply(msg);
+	}
+	else if (!simThread->send(msg)) {
+		spdlog::warn("sim queue full, dropped message {}", int(msg.kind));
+	}
 }
 
-void pong::game::serve(dir direction)
+pong::player_input pong::game::sampleInput(playerid id)
 {
-	auto mov = gvar::ball_speed;
-	if (direction == dir::left) {
-		mov = -mov;
-	}
+	using sf::Keyboard;
+	using sf::Joystick;
 
-	ball.shape.setPosition(gvar::playarea_width / 2, gvar::playarea_height / 2);
-	ball.velocity = { mov, 0 };
-}
+	player_input in;
 
-void pong::game::updatePlayer(player_t& player)
-{
-	using gvar::paddle_max_speed;
-	bool turbo = false;
-	auto mom = player.velocity;
+	// keyboard
+	auto& kb_controls = settings.get_keyboard_keys(id);
+	in.up = Keyboard::isKeyPressed(kb_controls.up);
+	in.down = Keyboard::isKeyPressed(kb_controls.down);
+	in.fast = Keyboard::isKeyPressed(kb_controls.fast);
 
-	if (player.ai)
+	// joystick
+	if (settings.using_joystick(id))
 	{
-		// TODO
-		static sf::Clock AIClock;
-		static const sf::Time AITime = sf::seconds(0.1f);
+		auto joyid = settings.get_joystick(id);
+		auto deadzone = settings.joystick_deadzone(id);
+
+		auto axis = Joystick::getAxisPosition(joyid, Joystick::Y);
+		// deadzone
+		if (abs(axis) > deadzone) {
+			in.axis = axis;
+			in.joystick = true;
+		}
 
-		if (AIClock.getElapsedTime() > AITime) {
-			AIClock.restart();
+		in.fast |= Joystick::isButtonPressed(joyid, 0);
+	}
 
-			const auto offset = ball.shape.getPosition() - player.shape.getPosition();
-			const auto ai_speed = 1;
-			const auto ydiff = abs(offset.y);
+	return in;
+}
 
-			if (ydiff >= ball.shape.getRadius()) {
-				mom.y += std::copysign(ai_speed, offset.y);
-				turbo = ydiff > 99;
-			}
-		}
+void pong::game::syncFrame(const match_frame& next)
+{
+	if (next.tick != frame.tick) {
+		stats.sample(next);
+	}
+	if (fx) {
+		emitEffects(next);
 	}
-	else // player
+	if (next.score != frame.score)
 	{
-		using sf::Keyboard;
-		using sf::Joystick;
-
-		// keyboard
-		auto& kb_controls = settings.get_keyboard_keys(player.id);
-		bool gofast_kb = Keyboard::isKeyPressed(kb_controls.fast);
-
-		if (Keyboard::isKeyPressed(kb_controls.up))
-			mom.y -= gvar::paddle_kb_speed;
-		else if (Keyboard::isKeyPressed(kb_controls.down))
-			mom.y += gvar::paddle_kb_speed;
-
-		// joystick
-		bool gofast_js = false;
-		if (settings.using_joystick(player.id))
-		{
-			auto joyid = settings.get_joystick(player.id);
-			auto deadzone = settings.joystick_deadzone(player.id);
-
-			auto axis = Joystick::getAxisPosition(joyid, Joystick::Y);
-			// deadzone
-			if (abs(axis) > deadzone)
-				mom.y = axis / 3;
-
-			gofast_js = Joystick::isButtonPressed(joyid, 0);
+		if (next.score != pair<int>()) {
+			stats.point(next.lastRally);
 		}
-
-		turbo = gofast_kb || gofast_js;
+		bg.update_score(next.score.first, next.score.second);
+		sceneCached = false;
 	}
 
-	// TODO: mover pra player.update()
-	mom.y = std::clamp(mom.y, -paddle_max_speed, paddle_max_speed);
+	frame = next;
+	placeViews(frame);
+}
+
+void pong::game::placeViews(const match_frame& shown)
+{
+	paddleView[0].setPosition(shown.pos[0]);
+	paddleView[1].setPosition(shown.pos[1]);
+	ballView.setPosition(shown.ballPos);
+}
 
-	if (turbo)
+void pong::game::emitEffects(const match_frame& next)
+{
+	// a partida não sabe das partículas: rebatida e gol aparecem no frame
+	// como rally/placar mudando, em qualquer modo (thread, netplay, espectador)
+	if (next.score != frame.score)
 	{
-		mom.y *= 1.25f;
+		if (next.score == pair<int>())
+			return; // reset
+
+		// onde a bola saiu, não onde ela recomeça
+		const float x = std::clamp(frame.ballPos.x, 0.f, gvar::playarea_width);
+		fx->emit({ .pos = { x, frame.ballPos.y }, .dir = { x < gvar::playarea_width / 2 ? 1.f : -1.f, 0 },
+			.spread = 1.3f, .speedMin = 100, .speedMax = 500, .lifeMin = 0.6f, .lifeMax = 1.2f,
+			.color = { 255, 90, 60 } }, 600);
 	}
-	else if (!player.ai && player.velocity == mom) {
-		mom.y *= 0.6f;
+	else if (next.rally > frame.rally)
+	{
+		fx->emit({ .pos = next.ballPos, .dir = next.ballVel, .spread = 0.9f, .speedMin = 120, .speedMax = 480,
+			.color = { 255, 220, 120 } }, 48);
 	}
 
-	player.velocity = mom;
-	player.update();
-
-	if (bg.border_collision(player.shape.getGlobalBounds())) {
-		player.velocity = {};
-		auto position = player.shape.getPosition();
+	// rastro: alguns por tick que passou
+	if (next.tick > frame.tick && next.ballVel != vec2())
+	{
+		auto color = ballView.getFillColor();
+		color.a = 160;
+		const int ticks = int(std::min<std::uint64_t>(next.tick - frame.tick, 8));
+		fx->emit({ .pos = next.ballPos, .dir = -next.ballVel, .spread = 0.5f, .speedMin = 10, .speedMax = 40,
+			.lifeMin = 0.15f, .lifeMax = 0.35f, .color = color }, 3 * ticks);
+	}
+}
 
-		if (collision(player.shape, bg.topBorder())) {
-			position.y = bg.getPoint(0).y + player.shape.getOrigin().y + 2;
-			//	p.y = 108;
-		}
-		else {
-			position.y = bg.getPoint(2).y - player.shape.getOrigin().y - 2;
-			//	p.y = 916;
-		}
+void pong::game::createBallSprite()
+{
+	// uma bola branca; a cor vai nos vértices
+	if (ballSprite.getSize().x > 0)
+		return;
 
-		player.shape.setPosition(position);
+	sf::CircleShape circle(32, 48);
+	if (ballSprite.create(64, 64))
+	{
+		ballSprite.setSmooth(true);
+		ballSprite.clear(sf::Color::Transparent);
+		ballSprite.draw(circle);
+		ballSprite.display();
 	}
-
 }
 
-void pong::game::updateBall()
+void pong::game::syncParty()
 {
-	player_t* player = nullptr;
-	auto mom = ball.velocity;
+	const auto& pads = party->paddles();
+	const auto& all = party->balls();
+	const float size = float(ballSprite.getSize().x);
+	const sf::Vector2f solid = { size / 2, size / 2 }; // miolo do círculo: cor lisa
+
+	partyVerts.resize((pads.size() + all.size()) * 6);
+	std::size_t v = 0;
+
+	auto quad = [&](point p, vec2 half, sf::Color color, bool textured) {
+		const sf::Vertex corners[4] = {
+			{ { p.x - half.x, p.y - half.y }, color, textured ? sf::Vector2f(0, 0) : solid },
+			{ { p.x + half.x, p.y - half.y }, color, textured ? sf::Vector2f(size, 0) : solid },
+			{ { p.x + half.x, p.y + half.y }, color, textured ? sf::Vector2f(size, size) : solid },
+			{ { p.x - half.x, p.y + half.y }, color, textured ? sf::Vector2f(0, size) : solid },
+		};
+		partyVerts[v++] = corners[0]; partyVerts[v++] = corners[1]; partyVerts[v++] = corners[2];
+		partyVerts[v++] = corners[0]; partyVerts[v++] = corners[2]; partyVerts[v++] = corners[3];
+	};
 
-	if (collision(ball.shape, player1.shape)) {
-		player = &player1;
-	}
-	else if (collision(ball.shape, player2.shape)) {
-		player = &player2;
+	const auto padPos = pads.get<comp::position>();
+	const auto padHalf = pads.get<comp::collider>();
+	const auto padSprite = pads.get<comp::sprite>();
+	for (std::size_t i = 0; i < pads.size(); i++) {
+		quad(padPos[i].value, padHalf[i].half, padSprite[i].color, false);
 	}
 
-	if (player)
-	{
-		using namespace gvar;
+	const auto ballPos = all.get<comp::position>();
+	const auto ballHalf = all.get<comp::collider>();
+	const auto ballColor = all.get<comp::sprite>();
+	for (std::size_t i = 0; i < all.size(); i++) {
+		quad(ballPos[i].value, ballHalf[i].half, ballColor[i].color, true);
+	}
+}
 
-		mom.x += ball_acceleration;
-		mom.y += player->velocity.y * 0.5f;
+void pong::game::syncBalls()
+{
+	const auto all = balls->balls();
+	const float r = balls->radius();
+	const float size = float(ballSprite.getSize().x);
+	const auto color = ballView.getFillColor();
 
-		ball.velocity = {
-			-std::clamp(mom.x, -ball_max_speed, ball_max_speed),
-			 std::clamp(mom.y, -ball_max_speed, ball_max_speed)
+	ballVerts.resize(all.size() * 6);
+	for (std::size_t i = 0; i < all.size(); i++)
+	{
+		const auto p = all[i].pos;
+		const sf::Vertex corners[4] = {
+			{ { p.x - r, p.y - r }, color, { 0, 0 } },
+			{ { p.x + r, p.y - r }, color, { size, 0 } },
+			{ { p.x + r, p.y + r }, color, { size, size } },
+			{ { p.x - r, p.y + r }, color, { 0, size } },
 		};
 
-		do
-		{
-			ball.update();
-		} while (collision(player->shape, ball.shape));
+		auto* v = &ballVerts[i * 6];
+		v[0] = corners[0]; v[1] = corners[1]; v[2] = corners[2];
+		v[3] = corners[0]; v[4] = corners[2]; v[5] = corners[3];
 	}
-	else ball.update();
+}
 
-	if (bg.border_collision(ball.shape.getGlobalBounds()))
-	{
-		ball.velocity.y = -ball.velocity.y;
+void pong::game::publish(const match_frame& f)
+{
+	if (caster) {
+		caster->push(f);
 	}
 }
 
-bool pong::game::updateScore()
+void pong::game::update()
 {
-	auto bounds = rect({}, bg.size());
-
-	if (!bounds.intersects(ball.shape.getGlobalBounds()))
+	if (watcher)
 	{
-		// ponto!
-		if (ball.velocity.x < 0)
-		{
-			// indo p/ direita, ponto player 1, saque player 2
-			score.first++;
-			serveDir = dir::left;
+		if (auto next = watcher->update()) {
+			syncFrame(*next);
 		}
-		else
-		{
-			// indo p/ esquerda, ponto player 2, saque player 1
-			score.second++;
-			serveDir = dir::right;
+		return;
+	}
+
+	if (netSession)
+	{
+		// o jogador local usa os controles do player 1
+		auto local = sampleInput(playerid::one);
+		// o Enter só vale quando um tick usa esse input: num frame
+		// segurado pelo netplay ele fica pro próximo (pausado, se perde)
+		local.serve = serveRequest;
+		if (netSession->update(sim, local, paused) || paused) {
+			serveRequest = false;
 		}
-		bg.update_score(score.first, score.second);
-		spdlog::info("score: {}x{} ; serve: {}", score.first, score.second, conv::to_string_view(serveDir));
+		syncFrame(sim.frame());
+		publish(frame);
+		return;
+	}
 
-		return true;
+	if (std::exchange(serveRequest, false)) {
+		send({ sim_message::serve });
 	}
-	else return false;
-}
 
-void pong::game::update()
-{
-	if (!paused)
+	sim_message msg;
+	msg.in.players[0] = sampleInput(playerid::one);
+	msg.in.players[1] = sampleInput(playerid::two);
+	send(msg);
+	inputClock.restart();
+
+	if (party)
 	{
-		updatePlayer(player1);
-		updatePlayer(player2);
-		updateBall();
+		if (!paused) {
+			party->step(msg.in.players);
+			syncParty();
+		}
+		return;
+	}
 
-		if (runTime.asMilliseconds() % 20 == 0) {
-			if (updateScore())
-			{
-				reset(player1);
-				reset(player2);
-				reset(ball);
+	if (simThread)
+	{
+		if (simThread->update()) {
+			syncFrame(simThread->latest());
+			publish(frame);
+		}
+	}
+	else if (!paused)
+	{
+		sim.step();
+		// espectadores veem o estado real, não o adiantado
+		publish(sim.frame());
+
+		if (balls)
+		{
+			balls->step(sim.player1.bounds(), sim.player2.bounds());
+			syncBalls();
+		}
+
+		if (runAhead > 0)
+		{
+			// mostra onde a partida vai estar daqui a N ticks se o input
+			// continuar o mesmo, e volta pro estado real. Estatísticas e
+			// efeitos ficam com o frame real: um gol previsto não conta
+			const auto real = sim.frame();
+			sim.save(runAheadState);
+			sim.mute(true);
+			for (int i = 0; i < runAhead; i++) {
+				sim.step();
 			}
+			const auto ahead = sim.frame();
+			sim.mute(false);
+			sim.restore(runAheadState);
+
+			syncFrame(real);
+			placeViews(ahead);
 		}
+		else syncFrame(sim.frame());
 	}
 }
 
-// scale 2 fit, center, preserve aspect ratio
-static sf::View get_play_view(float target_width)
+// scale 2 fit, center, preserve aspect ratio: a área de jogo inteira com a
+// maior escala que cabe na janela; o que sobra vira barra preta
+static sf::View get_play_view(sf::Vector2u window_size)
 {
-	float to_w = target_width;
-	float from_w = gvar::playarea_width;
-
-	if (from_w > to_w) {
-		std::swap(from_w, to_w);
+	auto view = sf::View(pong::rect(0, 0, gvar::playarea_width, gvar::playarea_height));
+	if (window_size.x == 0 || window_size.y == 0) {
+		return view; // minimizada
 	}
 
-	pong::rect vp;
-	vp.width = from_w / to_w;
-	vp.height = 1;
-	auto space_ratio = (to_w - from_w) / to_w;
-	vp.left = space_ratio / 2;
+	const float to_w = float(window_size.x), to_h = float(window_size.y);
+	const float scale = std::min(to_w / gvar::playarea_width, to_h / gvar::playarea_height);
 
-	auto view = sf::View(pong::rect(0,0, gvar::playarea_width, gvar::playarea_height));
+	pong::rect vp;
+	vp.width = gvar::playarea_width * scale / to_w;
+	vp.height = gvar::playarea_height * scale / to_h;
+	vp.left = (1 - vp.width) / 2;
+	vp.top = (1 - vp.height) / 2;
 	view.setViewport(vp);
 
 	return view;
 }
 
+void pong::game::createWindow()
+{
+	auto vidmode = sf::VideoMode{ settings.resolution.x, settings.resolution.y };
+	sf::Uint32 style = sf::Style::Default;
+
+	if (settings.fullscreen)
+	{
+		style = sf::Style::Fullscreen;
+		if (!vidmode.isValid()) {
+			spdlog::warn("{}x{} isn't a fullscreen mode, using the desktop's", vidmode.width, vidmode.height);
+			vidmode = sf::VideoMode::getDesktopMode();
+		}
+	}
+
+	// mesmo sf::RenderWindow: ImGui, texturas e fontes continuam valendo
+	window.create(vidmode, "Sf Pong!", style);
+	window.setFramerateLimit(60u);
+	updateView();
+}
+
+void pong::game::updateView()
+{
+	window.setView(get_play_view(window.getSize()));
+	sceneCached = false;
+}
+
+void pong::game::applyVideoSettings()
+{
+	spdlog::info("video: {}x{} {}", settings.resolution.x, settings.resolution.y,
+		settings.fullscreen ? "fullscreen" : "windowed");
+	createWindow();
+	wakeFrames = 3;
+}
+
+void pong::game::drawScene(sf::RenderTarget& target)
+{
+	target.draw(bg);
+	if (party)
+	{
+		target.draw(partyVerts, &ballSprite.getTexture());
+		return;
+	}
+	if (balls) {
+		target.draw(ballVerts, &ballSprite.getTexture());
+	}
+	if (fx) {
+		target.draw(*fx);
+	}
+	target.draw(ballView);
+	target.draw(paddleView[0]);
+	target.draw(paddleView[1]);
+}
+
 void pong::game::render()
 {
 	window.clear();
 
-	window.draw(bg);
-	window.draw(ball.shape);
-	window.draw(player1.shape);
-	window.draw(player2.shape);
+	if (!paused) {
+		sceneCached = false;
+		drawScene(window);
+		return;
+	}
+
+	// pausado: desenha a cena uma vez só, numa textura do tamanho da área
+	// visível (sem as barras)
+	const auto vp = window.getViewport(window.getView());
+	if (!sceneCached)
+	{
+		const sf::Vector2u size(std::max(vp.width, 1), std::max(vp.height, 1));
+		if (sceneCache.getSize() != size && !sceneCache.create(size.x, size.y)) {
+			drawScene(window);
+			return;
+		}
+
+		sceneCache.setView(sf::View(rect(0, 0, gvar::playarea_width, gvar::playarea_height)));
+		sceneCache.clear();
+		drawScene(sceneCache);
+		sceneCache.display();
+		sceneCached = true;
+	}
+
+	const auto view = window.getView();
+	sf::Sprite cached(sceneCache.getTexture());
+	cached.setPosition(float(vp.left), float(vp.top));
+	// em pixels da janela; getDefaultView() fica com o tamanho do create()
+	const auto pixels = window.getSize();
+	window.setView(sf::View(sf::FloatRect(0, 0, float(pixels.x), float(pixels.y))));
+	window.draw(cached);
+	window.setView(view);
 }
 
 
 void pong::game::reset()
 {
-	reset(player1);
-	reset(player2);
-	reset(ball);
+	if (netSession || watcher) {
+		spdlog::warn("reset ignored, the match is remote");
+		return;
+	}
 
-	score = {};
+	sceneCached = false;
+	send({ sim_message::reset });
 	bg.update_score(0, 0);
+
+	if (balls)
+	{
+		balls->clear();
+		balls->spawn(std::size_t(params.multiball));
+		syncBalls();
+	}
+	if (party)
+	{
+		party->reset();
+		syncParty();
+	}
+	if (fx) {
+		fx->clear();
+	}
+
+	if (!simThread) {
+		syncFrame(sim.frame());
+	}
 }
 
-void pong::game::reset(ball_t& b)
+
+bool pong::game::idle() const
 {
-	b.velocity = {};
-	b.shape.setPosition(gvar::playarea_width / 2, gvar::playarea_height / 2);
+	// --profile-frames precisa que os frames continuem passando, o
+	// espectador continuar recebendo e o netplay continuar trocando
+	// pacotes (acks, inputs, hash) mesmo pausado
+	return paused && sceneCached && wakeFrames == 0
+		&& params.profileFrames == 0 && !watcher && !netSession
+		&& menu.idle();
 }
 
-void pong::game::reset(player_t& p)
+void pong::game::handleEvent(sf::Event& event)
 {
-	const auto center = point(gvar::playarea_width / 2, gvar::playarea_height / 2);
-	const auto margin = 10;
-
-	if (p.id == playerid::one) {
-		p.shape.setPosition(gvar::paddle_width + margin, center.y);
-	}
-	else if (p.id == playerid::two) {
-		p.shape.setPosition(gvar::playarea_width - (gvar::paddle_width + margin), center.y);
+	// global events
+	switch (event.type)
+	{
+	case sf::Event::Closed:
+		window.close();
+		break;
+	case sf::Event::Resized:
+		updateView();
+		break;
 	}
 
-	p.velocity = {};
-}
+	processEvent(event);
+	menu.processEvent(event);
 
+	// alguns frames pro ImGui reagir (hover, abrir menus)
+	wakeFrames = 3;
+}
 
 int pong::game::main()
 {
 	while (window.isOpen())
 	{
 		sf::Event event;
-		while (window.pollEvent(event))
-		{
-			// global events
-			switch (event.type)
-			{
-			case sf::Event::Closed:
-				window.close();
-				break;
-			}
-
-			processEvent(event);
-			menu.processEvent(event);
+		if (idle() && window.waitEvent(event)) {
+			handleEvent(event);
+		}
+		while (window.pollEvent(event)) {
+			handleEvent(event);
 		}
 
 		auto dt = restartClock();
 
 		update();
+		telemetry::tick(); // partida inline, netplay e os eventos do próprio game
+		if (fx && !paused) {
+			fx->update(dt.asSeconds());
+		}
 		menu.update(dt);
 
 		render();
 		menu.render();
 
+		// até o swap; o sleep do limite de fps fica dentro do display()
+		if (!paused) {
+			stats.inputLag.push(inputClock.getElapsedTime().asSeconds() * 1000);
+		}
 		window.display();
+
+		if (wakeFrames > 0) {
+			wakeFrames--;
+		}
+
+		if (++frameCount == 1) {
+			startup::mark("first_full_frame");
+			spdlog::info("time to first frame: {:.1f} ms", startup::elapsed_ms());
+		}
+		if (frameCount == params.profileFrames) {
+			window.close();
+		}
 	}
 
 	return 0;
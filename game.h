@@ -1,76 +1,102 @@
 #pragma once
 #include <utility>
+#include <memory>
 #include "SFML/Graphics.hpp"
 #include "common.h"
 #include "game_config.h"
 #include "menu.h"
+#include "ring_buffer.h"
+#include "match.h"
+#include "sim_thread.h"
+#include "netplay.h"
+#include "broadcast.h"
+#include "batch.h"
+#include "multiball.h"
+#include "particles.h"
+#include "party.h"
 
 namespace pong
 {
-	bool collision(const sf::Shape& a, const sf::Shape& b);
-	bool collision(const sf::Shape& a, const rect& b);
-	bool collision(const rect& a, const rect& b);
-
 	void constrain_pos(pos& p);
 
-	enum struct gamemode { singleplayer, multiplayer, aitest };
-	
 	struct arguments_t
 	{
 		std::string configFile = "game.cfg";
+		std::string arenaFile = "default-arena.info"; // não abriu: quadra padrão
+		std::string gutsFile = "default-guts.info";   // não abriu: valores de gvar.h
 		bool showHelp = false;
-	};
 
-	struct player_t
-	{
-		player_t(playerid pid);
+		// --profile-startup
+		bool profileStartup = false;
+		int profileFrames = 0; // sai depois de N frames, 0 = não sai
+		std::string profileJson; // "-" = stdout
+		double startupBudget = 0; // ms até o 1o frame completo, 0 = sem limite
 
-		void update()
-		{
-			shape.move(velocity);
-		}
+		std::string binlogFile = "sfpong.binlog"; // vazio = desligado
+		std::string decodeLog;
+		std::string telemetryDir; // vazio = desligado
 
-		point previewPos() const {
-			return shape.getPosition() + velocity;
-		}
+		bool threadedSim = false; // simulação na sua própria thread
+		int simCpu = -1; // afinidade da thread da simulação, -1 = nenhuma
+		int runAhead = 0; // ticks simulados à frente só pra mostrar
+
+		// netplay, 0 = desligado
+		int netPort = 0;
+		std::string netPeer = "127.0.0.1:7001";
+		int netSide = 1;
+		link_conditions netLink;
+
+		int broadcastPort = 0; // manda a partida pra espectadores
+		std::string spectate;  // "host:porta": só assiste
+
+		batch_config batch; // --simulate: roda batch.matches partidas sem janela e sai
+
+		int multiball = 0; // bolas extras, 0 = só a da partida
+		int particles = 100000; // capacidade do pool de partículas, 0 = sem
 
-		sf::RectangleShape shape;
-		vec2 velocity;
-		playerid id;
-		bool ai = false;
+		// modo festa: com mais de 2 jogadores ou mais de 1 bola
+		int players = 2;
+		int partyBalls = 1;
 	};
 
-	struct ball_t
+	// histórico pro overlay de stats, sem alocação
+	struct match_stats
 	{
-		ball_t();
+		static constexpr size_t history = 240; // ~4s a 60 fps
 
-		void update()
-		{
-			shape.move(velocity);
-		}
+		util::ring_buffer<float, history> ballSpeed, p1Speed, p2Speed;
+		util::ring_buffer<float, 64> rallies;
+		util::ring_buffer<float, 120> inputLag; // ms do input amostrado até o display()
 
-		sf::CircleShape shape;
-		vec2 velocity;
+		void sample(const match_frame& frame) noexcept;
+		void point(int rally) noexcept;
 	};
 
 	struct background : sf::Drawable, sf::Transformable
 	{
-		explicit background(size2d area);
+		// map nullptr: arena::standard(area)
+		explicit background(size2d area, std::shared_ptr<const arena> map = nullptr);
+
+		// pode rodar fora da main thread, antes do primeiro draw
+		bool load_font(const char* path);
 
 		void update_score(int p1, int p2);
 
 		auto size() const { return mySize; }
 		void size(size2d value);
 
-		bool border_collision(const rect& bounds) const;
+		// bordas, paredes extras e obstáculos da arena
+		void set_arena(std::shared_ptr<const arena> value);
+		const arena& map() const noexcept { return *myArena; }
+
+		court_t court() const;
 
 		auto& topBorder() const noexcept { return top; }
 		auto& bottomBorder() const noexcept { return bottom; }
 
-		auto innerBounds() const {
-			auto topleft = top.getTransform().transformPoint(top.getPoint(3));
-			auto bottright = bottom.getTransform().transformPoint(bottom.getPoint(1));
-			return rect(topleft, bottright - topleft);
+		rect innerBounds() const {
+			const auto& a = *myArena;
+			return { a.top.left, a.top.top + a.top.height, a.top.width, a.bottom.top - (a.top.top + a.top.height) };
 		}
 
 		point getPoint(size_t i) const;
@@ -78,7 +104,9 @@ namespace pong
 	private:
 		size2d mySize, borderSize;
 
+		std::shared_ptr<const arena> myArena;
 		sf::RectangleShape top, bottom;
+		sf::VertexArray solids{ sf::Triangles }; // paredes extras e obstáculos
 		struct {
 			sf::VertexArray verts{ sf::Triangles };
 			sf::Transform transform;
@@ -107,6 +135,7 @@ namespace pong
 		void update();
 		void reset();
 		void render();
+		void drawScene(sf::RenderTarget& target);
 
 		sf::Time restartClock() {
 			auto elapsed = clock.restart();
@@ -115,42 +144,103 @@ namespace pong
 		}
 
 		// entities
-		player_t player1{ playerid::one }, player2{ playerid::two };
-		ball_t ball;
 		background bg;
-
-		// controls
-		void serve(dir direction);
+		match sim; // com threadedSim, só a thread da simulação mexe
+		match_frame frame; // último estado publicado
 
 		// status
+		match_stats stats;
 		bool paused = true;
-		pair<int> score;
-		dir serveDir = dir::left;
 		sf::Time runTime;
 		gamemode mode;
+		long frameCount = 0;
+		int runAhead = 0; // ver arguments_t::runAhead
+		static constexpr int max_run_ahead = 8;
 		
 		void changeMode(gamemode m) noexcept;
+		void setPaused(bool value) noexcept;
 
-		bool waiting_to_serve() const noexcept;
+		// resolução e tela cheia de settings, sem recriar o ImGui nem recarregar nada
+		void applyVideoSettings();
 
 		void newGame(gamemode m) {
 			reset();
 			changeMode(m);
-			paused = false;
+			setPaused(false);
 		}
 
 		int main();
 
+		// nullptr sem --threaded
+		const sim_thread* simulation() const noexcept { return simThread.get(); }
+		// nullptr sem --net-port
+		const netplay* network() const noexcept { return netSession.get(); }
+		// nullptr sem --broadcast / --spectate
+		const broadcaster* broadcasting() const noexcept { return caster.get(); }
+		const spectator* watching() const noexcept { return watcher.get(); }
+		// nullptr sem --multiball
+		const ball_field* multiball() const noexcept { return balls.get(); }
+		// nullptr com --particles 0
+		const particle_system* effects() const noexcept { return fx.get(); }
+		// nullptr sem --players / --balls
+		const party_match* partyMode() const noexcept { return party.get(); }
+
+		// run-ahead precisa salvar e restaurar a partida na main thread, e só
+		// a partida: sem thread, rede, bolas extras nem party
+		bool supportsRunAhead() const noexcept {
+			return !simThread && !netSession && !watcher && !balls && !party;
+		}
+
 	private:
 		themenu menu;
 		friend class themenu;
 
-		void reset(player_t& player);
-		void reset(ball_t& ball);
-
-		void updatePlayer(player_t& player);
-		void updateBall();
-		bool updateScore();
-
+		// idle: pausado, a cena congelada fica numa textura e o loop
+		// dorme em waitEvent() até chegar input
+		sf::RenderTexture sceneCache;
+		bool sceneCached = false;
+		int wakeFrames = 0;
+
+		bool idle() const;
+		void handleEvent(sf::Event& event);
+
+		// a área de jogo em escala, centralizada na janela (letterbox)
+		void createWindow();
+		void updateView();
+
+		std::unique_ptr<sim_thread> simThread;
+		std::unique_ptr<netplay> netSession;
+		std::unique_ptr<broadcaster> caster;
+		std::unique_ptr<spectator> watcher;
+		bool serveRequest = false; // Enter, vai pro próximo tick
+		game_state runAheadState;
+		sf::Clock inputClock; // desde a última amostra de input
+
+		// views: só desenham o que veio em frame
+		sf::RectangleShape paddleView[2];
+		sf::CircleShape ballView;
+
+		// multibola: um quad texturizado por bola, um draw call só
+		std::unique_ptr<ball_field> balls;
+		sf::VertexArray ballVerts{ sf::Triangles };
+		sf::RenderTexture ballSprite;
+		void createBallSprite();
+		void syncBalls();
+
+		// modo festa: substitui sim, tudo num vertex array com ballSprite
+		std::unique_ptr<party_match> party;
+		sf::VertexArray partyVerts{ sf::Triangles };
+		void syncParty();
+
+		// faíscas nas rebatidas, explosão no gol e rastro da bola
+		std::unique_ptr<particle_system> fx;
+		void emitEffects(const match_frame& next);
+
+		void send(const sim_message& msg);
+		player_input sampleInput(playerid id);
+		void syncFrame(const match_frame& next);
+		// só as posições na tela; o run-ahead mostra um frame que não aconteceu
+		void placeViews(const match_frame& shown);
+		void publish(const match_frame& f);
 	};
 }
@@ -0,0 +1,84 @@
+#include <boost/property_tree/ptree.hpp>
+#include <boost/property_tree/info_parser.hpp>
+#include "common.h"
+#include "guts.h"
+
+namespace
+{
+	using pong::physics_profile;
+
+	// chaves de default-guts.info
+	constexpr struct { std::string_view key; float physics_profile::* field; } fields[] = {
+		{ "paddle.kb_speed", &physics_profile::paddle_kb_speed },
+		{ "paddle.max_speed", &physics_profile::paddle_max_speed },
+		{ "paddle.width", &physics_profile::paddle_width },
+		{ "paddle.height", &physics_profile::paddle_height },
+		{ "ball.speed", &physics_profile::ball_speed },
+		{ "ball.acceleration", &physics_profile::ball_acceleration },
+		{ "ball.max_speed", &physics_profile::ball_max_speed },
+		{ "ball.radius", &physics_profile::ball_radius },
+	};
+}
+
+bool pong::physics_profile::valid() const noexcept
+{
+	// aceleração pode ser 0 (bola sem ganhar velocidade)
+	for (auto& f : fields)
+	{
+		const float v = this->*f.field;
+		if (f.field == &physics_profile::ball_acceleration ? !(v >= 0) : !(v > 0))
+			return false;
+	}
+	return true;
+}
+
+float pong::physics_profile::* pong::physics_profile::field(std::string_view key) noexcept
+{
+	for (auto& f : fields)
+	{
+		if (f.key == key)
+			return f.field;
+	}
+	return nullptr;
+}
+
+std::optional<pong::physics_profile> pong::physics_profile::load(const std::filesystem::path& file)
+{
+	namespace pt = boost::property_tree;
+
+	pt::ptree tree;
+	physics_profile p;
+
+	try
+	{
+		pt::read_info(file.string(), tree);
+
+		// get(chave, padrão) engoliria um valor que não é número
+		for (auto& f : fields)
+		{
+			if (auto node = tree.get_child_optional(std::string(f.key))) {
+				p.*f.field = node->get_value<float>();
+			}
+		}
+	}
+	catch (const pt::ptree_error& e)
+	{
+		spdlog::error("guts {}: {}", file.string(), e.what());
+		return std::nullopt;
+	}
+
+	if (!p.valid())
+	{
+		spdlog::error("guts {}: sizes and speeds must be positive, ball.acceleration can't be negative", file.string());
+		return std::nullopt;
+	}
+
+	return p;
+}
+
+pong::physics_profile pong::physics_profile::load_or_builtin(const std::filesystem::path& file)
+{
+	if (file.empty() || !std::filesystem::exists(file))
+		return {};
+	return load(file).value_or(physics_profile());
+}
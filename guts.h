@@ -0,0 +1,56 @@
+#pragma once
+// "guts": velocidades, tamanhos e aceleração da física (default-guts.info).
+// builtin_guts são os valores de gvar como constexpr; match usa esse tipo
+// quando o perfil carregado é igual a ele, e as contas continuam dobradas
+// em tempo de compilação. Qualquer outro perfil vai pelo caminho em runtime
+#include <filesystem>
+#include <optional>
+#include <string_view>
+#include "gvar.h"
+
+namespace pong
+{
+	struct builtin_guts
+	{
+		static constexpr float paddle_kb_speed = gvar::paddle_kb_speed;
+		static constexpr float paddle_max_speed = gvar::paddle_max_speed;
+		static constexpr float paddle_width = gvar::paddle_width;
+		static constexpr float paddle_height = gvar::paddle_height;
+
+		static constexpr float ball_speed = gvar::ball_speed;
+		static constexpr float ball_acceleration = gvar::ball_acceleration;
+		static constexpr float ball_max_speed = gvar::ball_max_speed;
+		static constexpr float ball_radius = gvar::ball_radius;
+	};
+
+	// mesmos nomes de builtin_guts: o código da física é template nos dois
+	struct physics_profile
+	{
+		float paddle_kb_speed = builtin_guts::paddle_kb_speed;
+		float paddle_max_speed = builtin_guts::paddle_max_speed;
+		float paddle_width = builtin_guts::paddle_width;
+		float paddle_height = builtin_guts::paddle_height;
+
+		float ball_speed = builtin_guts::ball_speed;
+		float ball_acceleration = builtin_guts::ball_acceleration;
+		float ball_max_speed = builtin_guts::ball_max_speed;
+		float ball_radius = builtin_guts::ball_radius;
+
+		bool operator==(const physics_profile&) const = default;
+
+		// tamanhos e velocidades positivos, aceleração >= 0
+		bool valid() const noexcept;
+
+		// campo pela chave do arquivo ("ball.max_speed"); nullptr se não existir
+		static float physics_profile::* field(std::string_view key) noexcept;
+
+		// igual ao compilado: match usa builtin_guts
+		bool builtin() const noexcept { return *this == physics_profile(); }
+
+		// campos que faltarem ficam com o valor padrão. nullopt se não abrir
+		// ou tiver valor inválido (motivo no log)
+		static std::optional<physics_profile> load(const std::filesystem::path& file);
+		// sem o arquivo ou com erro: o perfil compilado
+		static physics_profile load_or_builtin(const std::filesystem::path& file);
+	};
+}
@@ -3,10 +3,12 @@
 namespace gvar
 {
 	constexpr float playarea_width = 1280, playarea_height = 1024;
+	constexpr int tick_rate = 60; // ticks de física por segundo
 
 	constexpr float paddle_kb_speed = 1;
 	constexpr float paddle_max_speed = 30;
 	constexpr float paddle_width = 25, paddle_height = 150;
+	constexpr float paddle_outline = 1.5f; // faz parte da caixa de colisão
 	
 	constexpr float ball_speed = 5;
 	constexpr float ball_max_speed = 20;
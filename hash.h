@@ -0,0 +1,26 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+
+namespace util
+{
+    // FNV-1a 64 bits
+    constexpr std::uint64_t fnv1a_basis = 0xcbf29ce484222325ull;
+    constexpr std::uint64_t fnv1a_prime = 0x100000001b3ull;
+
+    inline std::uint64_t fnv1a(const void* data, std::size_t size, std::uint64_t h = fnv1a_basis) noexcept
+    {
+        auto* p = static_cast<const unsigned char*>(data);
+        for (std::size_t i = 0; i < size; i++) {
+            h ^= p[i];
+            h *= fnv1a_prime;
+        }
+        return h;
+    }
+
+    template<class T>
+    std::uint64_t fnv1a(const T& value, std::uint64_t h = fnv1a_basis) noexcept
+    {
+        return fnv1a(&value, sizeof(T), h);
+    }
+}
@@ -1,4 +1,5 @@
 #include <spdlog/sinks/stdout_color_sinks.h>
+#include <spdlog/async.h>
 #include <SFML/Graphics.hpp>
 #include <imgui-SFML.h>
 #include <boost/property_tree/ptree.hpp>
@@ -6,10 +7,15 @@
 #include <lyra/lyra.hpp>
 #include <fmt/format.h>
 #include <filesystem>
+#include <algorithm>
 
 #include "game.h"
+#include "sweep.h"
 #include "menu.h"
 #include "common.h"
+#include "startup.h"
+#include "binlog.h"
+#include "telemetry.h"
 
 namespace fs = std::filesystem;
 namespace ckey = pong::ckey;
@@ -18,30 +24,163 @@ using fmt::print;
 
 int main(int argc, const char* argv[])
 {
+	namespace startup = pong::startup;
 	pong::arguments_t params;
+	float netLoss = 0;
+	std::string batchMode = "aitest";
+	std::vector<std::string> sweepAxes;
+	int sweepLatin = 0;
+	std::string sweepCsv;
+	std::string resultsFile;
 
 	auto cli = lyra::cli()
 		| lyra::help(params.showHelp).description("sfPong cmd options")
 		| lyra::opt(params.configFile, "game.cfg")["--config"]("arquivo config.")
+		| lyra::opt(params.arenaFile, "file")["--arena"]("arena: bordas, obstáculos e gols (default-arena.info).")
+		| lyra::opt(params.gutsFile, "file")["--guts"]("física: velocidades e tamanhos (default-guts.info).")
+		| lyra::opt(params.profileStartup)["--profile-startup"]("mede o tempo de cada etapa do startup.")
+		| lyra::opt(params.profileFrames, "frames")["--profile-frames"]("sai depois de N frames.")
+		| lyra::opt(params.profileJson, "file")["--profile-json"]("grava o perfil em JSON ('-' = stdout).")
+		| lyra::opt(params.startupBudget, "ms")["--startup-budget"]("falha se o 1o frame passar de N ms.")
+		| lyra::opt(params.binlogFile, "file")["--binlog"]("arquivo do log binário.")
+		| lyra::opt(params.decodeLog, "file")["--decode-log"]("imprime um log binário e sai.")
+		| lyra::opt(params.telemetryDir, "dir")["--telemetry"]("grava eventos da partida em dir.")
+		| lyra::opt(params.threadedSim)["--threaded"]("roda a simulação numa thread separada.")
+		| lyra::opt(params.simCpu, "cpu")["--sim-cpu"]("fixa a thread da simulação numa CPU.")
+		| lyra::opt(params.runAhead, "ticks")["--run-ahead"]("mostra N ticks à frente pra cortar latência.")
+		| lyra::opt(params.netPort, "port")["--net-port"]("netplay: porta UDP local.")
+		| lyra::opt(params.netPeer, "host:port")["--net-peer"]("netplay: endereço do outro jogador.")
+		| lyra::opt(params.netSide, "1|2")["--net-side"]("netplay: lado do jogador local.")
+		| lyra::opt(params.netLink.latencyMs, "ms")["--net-latency"]("netplay: atraso simulado nos envios.")
+		| lyra::opt(params.netLink.jitterMs, "ms")["--net-jitter"]("netplay: variação simulada do atraso.")
+		| lyra::opt(netLoss, "%")["--net-loss"]("netplay: perda de pacotes simulada.")
+		| lyra::opt(params.broadcastPort, "port")["--broadcast"]("transmite a partida pra espectadores nessa porta UDP.")
+		| lyra::opt(params.spectate, "host:port")["--spectate"]("assiste a partida transmitida por outro sfPong.")
+		| lyra::opt(params.multiball, "N")["--multiball"]("N bolas extras, com colisão entre elas.")
+		| lyra::opt(params.players, "N")["--players"]("modo festa: 2 a 4 jogadores (esquerda, direita, cima, baixo).")
+		| lyra::opt(params.partyBalls, "N")["--balls"]("modo festa: N bolas ao mesmo tempo.")
+		| lyra::opt(params.particles, "N")["--particles"]("máximo de partículas vivas, 0 desliga os efeitos.")
+		| lyra::opt(params.batch.matches, "N")["--simulate"]("roda N partidas sem janela, imprime o resultado e sai.")
+		| lyra::opt(params.batch.threads, "T")["--threads"]("--simulate: threads, 0 = uma por núcleo.")
+		| lyra::opt(params.batch.seed, "S")["--seed"]("--simulate: seed das partidas.")
+		| lyra::opt(batchMode, "mode")["--mode"]("--simulate: singleplayer, multiplayer ou aitest.")
+		| lyra::opt(params.batch.points, "P")["--points"]("--simulate: pontos pra ganhar.")
+		| lyra::opt(params.batch.maxTicks, "ticks")["--max-ticks"]("--simulate: desiste da partida depois disso.")
+		| lyra::opt(sweepAxes, "key=min:max:steps")["--sweep"]("--simulate: varre um parâmetro da física (ex. ball.max_speed=10:30:5), N partidas por ponto.")
+		| lyra::opt(sweepLatin, "N")["--latin"]("--sweep: N pontos num hipercubo latino em vez da grade.")
+		| lyra::opt(sweepCsv, "file")["--sweep-csv"]("--sweep: grava a tabela em CSV.")
+		| lyra::opt(resultsFile, "file")["--results"]("--simulate: grava cada ponto num arquivo colunar (ver sfpong-results).")
 		;
 
-	auto cli_result = cli.parse({ argc, argv });
+	auto cli_result = startup::timed("lyra.parse", [&] { return cli.parse({ argc, argv }); });
 	if (!cli_result) {
 		print(stderr, "CLI error: {}\n", cli_result.message());
 		return 5;
 	}
 	
+	params.netLink.loss = std::clamp(netLoss / 100, 0.f, 1.f);
+
 	if (params.showHelp) {
 		std::cout << cli << '\n';
 		return 0;
 	}
 
-	auto logger_ = spdlog::stdout_color_st("sfPong");
-	spdlog::set_default_logger(logger_);
+	if (!params.decodeLog.empty()) {
+		return pong::binlog::decode(params.decodeLog, stdout) ? 0 : 1;
+	}
+
+	// sem janela, sem ImGui, sem log: só a simulação
+	if (params.batch.matches > 0)
+	{
+		if (!pong::parse_gamemode(batchMode, params.batch.mode)) {
+			print(stderr, "CLI error: unknown mode '{}'\n", batchMode);
+			return 5;
+		}
+		params.batch.guts = pong::physics_profile::load_or_builtin(params.gutsFile);
+		// como no jogo: sem o arquivo, ou sem abrir, a quadra padrão
+		if (std::filesystem::exists(params.arenaFile)) {
+			params.batch.map = pong::arena::load(params.arenaFile);
+			if (!params.batch.map) {
+				print(stderr, "can't load arena {}, using the standard court\n", params.arenaFile);
+			}
+		}
+
+		pong::columnar::writer results;
+		if (!resultsFile.empty() && !pong::open_results(results, resultsFile)) {
+			print(stderr, "can't write {}\n", resultsFile);
+			return 1;
+		}
+		// false: o arquivo não foi gravado inteiro
+		auto closeResults = [&] {
+			if (!results.is_open())
+				return true;
+			if (!results.close()) {
+				print(stderr, "can't write {} (disk full?)\n", resultsFile);
+				return false;
+			}
+			print("  results: {} rows, {:.1f} MB ({:.1f} MB uncompressed) -> {}\n",
+				results.rows(), results.bytes() / 1e6, results.raw_bytes() / 1e6, resultsFile);
+			return true;
+		};
+
+		if (!sweepAxes.empty())
+		{
+			pong::sweep_config sweep{ params.batch, {}, sweepLatin };
+			for (auto& text : sweepAxes)
+			{
+				pong::sweep_axis axis;
+				if (!pong::parse_sweep_axis(text, axis)) {
+					print(stderr, "CLI error: bad --sweep '{}' (key=min:max:steps, keys as in default-guts.info)\n", text);
+					return 5;
+				}
+				sweep.axes.push_back(axis);
+			}
+
+			const auto points = pong::sweep_points(sweep);
+			if (!std::all_of(points.begin(), points.end(), [](auto& p) { return p.valid(); })) {
+				print(stderr, "CLI error: --sweep leaves sizes or speeds <= 0, or a negative acceleration\n");
+				return 5;
+			}
+
+			auto result = pong::run_sweep(sweep, results.is_open() ? &results : nullptr);
+			pong::write_sweep(stdout, sweep, result, false);
+			const bool saved = closeResults();
+			if (!sweepCsv.empty())
+			{
+				auto csv = std::fopen(sweepCsv.c_str(), "w");
+				if (!csv) {
+					print(stderr, "can't write {}\n", sweepCsv);
+					return 1;
+				}
+				pong::write_sweep(csv, sweep, result, true);
+				std::fclose(csv);
+			}
+			return saved ? 0 : 1;
+		}
+
+		auto result = pong::run_batch(params.batch, results.is_open() ? &results : nullptr);
+		pong::print_batch(stdout, params.batch, result);
+		return closeResults() ? 0 : 1;
+	}
+
+	{
+		startup::scoped_phase _p_("spdlog.setup");
+		// async: terminal lento ou saída redirecionada não trava o frame
+		spdlog::init_thread_pool(8192, 1);
+		auto logger_ = spdlog::stdout_color_mt<spdlog::async_factory_nonblock>("sfPong");
+		spdlog::set_default_logger(logger_);
 #ifndef NDEBUG
-	spdlog::set_level(spdlog::level::debug);
+		spdlog::set_level(spdlog::level::debug);
 #endif // !NDEBUG
 
+		if (!params.binlogFile.empty()) {
+			pong::binlog::start(params.binlogFile);
+		}
+		if (!params.telemetryDir.empty()) {
+			pong::telemetry::start(params.telemetryDir);
+		}
+	}
+
 	spdlog::debug("CWD: {}", fs::current_path().string());
 
 	// game instance
@@ -52,5 +191,31 @@ int main(int argc, const char* argv[])
 		r = game.main();
 	}
 
+	if (params.profileStartup)
+	{
+		startup::print_report(stderr);
+
+		if (!params.profileJson.empty())
+		{
+			if (params.profileJson == "-") {
+				startup::write_json(stdout, params.startupBudget);
+			}
+			else if (auto* out = std::fopen(params.profileJson.c_str(), "w")) {
+				startup::write_json(out, params.startupBudget);
+				std::fclose(out);
+			}
+			else spdlog::error("failed to open {}", params.profileJson);
+		}
+
+		const auto ttff = startup::mark_ms("first_full_frame");
+		if (params.startupBudget > 0 && (ttff < 0 || ttff > params.startupBudget)) {
+			print(stderr, "startup budget exceeded: {:.1f} ms > {:.1f} ms\n", ttff, params.startupBudget);
+			r = 6;
+		}
+	}
+
+	pong::telemetry::stop();
+	pong::binlog::stop();
+	spdlog::shutdown();
 	return r;
 }
\ No newline at end of file
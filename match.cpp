@@ -0,0 +1,532 @@
+#include <algorithm>
+#include <cmath>
+#include <utility>
+#include "match.h"
+#include "gvar.h"
+#include "convert.h"
+#include "binlog.h"
+#include "telemetry.h"
+#include "hash.h"
+
+
+pong::player_t::player_t(playerid pid) : id(pid)
+{
+	resize(gvar::paddle_width, gvar::paddle_height);
+}
+
+void pong::player_t::resize(float width, float height) noexcept
+{
+	// o contorno desenhado também bate na bola
+	using gvar::paddle_outline;
+	box = { -paddle_outline, -height / 2 - paddle_outline, width + 2 * paddle_outline, height + 2 * paddle_outline };
+}
+
+pong::ball_t::ball_t()
+{
+	radius = gvar::ball_radius;
+}
+
+
+std::uint64_t pong::hash(const game_state& s) noexcept
+{
+	auto h = util::fnv1a_basis;
+	for (auto& p : s.paddles)
+	{
+		h = util::fnv1a(p.pos, h);
+		h = util::fnv1a(p.vel, h);
+		h = util::fnv1a(p.aiWait, h);
+		h = util::fnv1a(p.ai, h);
+	}
+	h = util::fnv1a(s.ballPos, h);
+	h = util::fnv1a(s.ballVel, h);
+	for (auto& in : s.input.players)
+	{
+		h = util::fnv1a(in.axis, h);
+		h = util::fnv1a(in.up, h);
+		h = util::fnv1a(in.down, h);
+		h = util::fnv1a(in.fast, h);
+		h = util::fnv1a(in.joystick, h);
+		h = util::fnv1a(in.serve, h);
+	}
+	h = util::fnv1a(s.score, h);
+	h = util::fnv1a(s.rally, h);
+	h = util::fnv1a(s.lastRally, h);
+	h = util::fnv1a(s.tick, h);
+	h = util::fnv1a(s.rng, h);
+	h = util::fnv1a(s.serveDir, h);
+	h = util::fnv1a(s.paused, h);
+	return h;
+}
+
+
+pong::court_t pong::court_t::from(std::shared_ptr<const arena> map)
+{
+	return { map->size, map->top, map->bottom, std::move(map) };
+}
+
+pong::court_t pong::court_t::standard(size2d area)
+{
+	return from(arena::standard(area));
+}
+
+pong::match::match(court_t court_, std::uint64_t seed, const physics_profile& guts)
+	: court(court_), profile(guts), builtin(guts.builtin()), rng(squares::key(seed))
+{
+	player1.resize(profile.paddle_width, profile.paddle_height);
+	player2.resize(profile.paddle_width, profile.paddle_height);
+	ball.radius = profile.ball_radius;
+	reset();
+}
+
+void pong::match::rematch(std::uint64_t seed, const physics_profile& guts)
+{
+	profile = guts;
+	builtin = guts.builtin();
+	player1.resize(profile.paddle_width, profile.paddle_height);
+	player2.resize(profile.paddle_width, profile.paddle_height);
+	player1.ai = player2.ai = false;
+	ball.radius = profile.ball_radius;
+
+	input = {};
+	isPaused = true;
+	serveDir = dir::left;
+	tick = 0;
+	rng = squares::key(seed);
+	physEvents.clear();
+	reset();
+}
+
+void pong::match::apply(const sim_message& msg)
+{
+	switch (msg.kind)
+	{
+	case sim_message::input:
+		input = msg.in;
+		break;
+	case sim_message::serve:
+		if (waiting_to_serve()) {
+			serve(serveDir);
+		}
+		break;
+	case sim_message::reset:
+		reset();
+		break;
+	case sim_message::mode:
+		changeMode(gamemode(msg.arg));
+		break;
+	case sim_message::pause:
+		isPaused = true;
+		break;
+	case sim_message::resume:
+		isPaused = false;
+		break;
+	case sim_message::toggle_ai:
+	{
+		auto& player = playerid(msg.arg) == playerid::one ? player1 : player2;
+		player.ai = !player.ai;
+		spdlog::debug("DEV. Player{} Ai = {}", msg.arg + 1, player.ai);
+		break;
+	}
+	}
+}
+
+pong::match_frame pong::match::frame() const noexcept
+{
+	match_frame f;
+	f.tick = tick;
+	f.pos[0] = player1.pos;
+	f.pos[1] = player2.pos;
+	f.ballPos = ball.pos;
+	f.vel[0] = player1.vel;
+	f.vel[1] = player2.vel;
+	f.ballVel = ball.vel;
+	f.score = score;
+	f.rally = rally;
+	f.lastRally = lastRally;
+	f.ai[0] = player1.ai;
+	f.ai[1] = player2.ai;
+	f.paused = isPaused;
+	return f;
+}
+
+void pong::match::save(game_state& out) const noexcept
+{
+	const player_t* players[] = { &player1, &player2 };
+	for (int i = 0; i < 2; i++)
+	{
+		auto& p = out.paddles[i];
+		p.pos = players[i]->pos;
+		p.vel = players[i]->vel;
+		p.aiWait = players[i]->aiWait;
+		p.ai = players[i]->ai;
+	}
+
+	out.ballPos = ball.pos;
+	out.ballVel = ball.vel;
+	out.input = input;
+	out.score[0] = score.first;
+	out.score[1] = score.second;
+	out.rally = rally;
+	out.lastRally = lastRally;
+	out.tick = tick;
+	out.rng = rng;
+	out.serveDir = serveDir;
+	out.paused = isPaused;
+}
+
+void pong::match::restore(const game_state& in) noexcept
+{
+	player_t* players[] = { &player1, &player2 };
+	for (int i = 0; i < 2; i++)
+	{
+		auto& p = in.paddles[i];
+		players[i]->pos = p.pos;
+		players[i]->vel = p.vel;
+		players[i]->aiWait = p.aiWait;
+		players[i]->ai = p.ai;
+	}
+
+	ball.pos = in.ballPos;
+	ball.vel = in.ballVel;
+	input = in.input;
+	score = { in.score[0], in.score[1] };
+	rally = in.rally;
+	lastRally = in.lastRally;
+	tick = in.tick;
+	rng = in.rng;
+	serveDir = in.serveDir;
+	isPaused = in.paused;
+
+	// eventos são do tick que gerou, não do estado
+	physEvents.clear();
+}
+
+void pong::match::emit(telemetry::event_type type, std::uint8_t player, std::uint16_t data,
+	float f0, float f1, float f2, float f3) const noexcept
+{
+	if (!muted) {
+		telemetry::emit(type, player, data, f0, f1, f2, f3);
+	}
+}
+
+void pong::match::changeMode(gamemode m) noexcept
+{
+	switch (m)
+	{
+	default:
+	case pong::gamemode::singleplayer:
+		player1.ai = false;
+		player2.ai = true;
+		break;
+	case pong::gamemode::multiplayer:
+		player1.ai = player2.ai = false;
+		break;
+	case pong::gamemode::aitest:
+		player1.ai = player2.ai = true;
+		break;
+	}
+
+	emit(telemetry::event_type::mode_change, 0, std::uint16_t(m));
+}
+
+bool pong::match::waiting_to_serve() const noexcept
+{
+	return !isPaused
+		&& ball.vel == vec2()
+		&& ball.pos == point(gvar::playarea_width / 2, gvar::playarea_height / 2);
+}
+
+void pong::match::serve(dir direction)
+{
+	auto mov = profile.ball_speed;
+	if (direction == dir::left) {
+		mov = -mov;
+	}
+
+	ball.pos = { gvar::playarea_width / 2, gvar::playarea_height / 2 };
+	ball.vel = { mov, 0 };
+
+	emit(telemetry::event_type::serve, std::uint8_t(direction), 0, ball.vel.x, ball.vel.y);
+}
+
+template<class G>
+void pong::match::updatePlayer(player_t& player, const player_input& in, const G& g)
+{
+	const auto paddle_max_speed = g.paddle_max_speed;
+	bool turbo = false;
+	auto mom = player.vel;
+
+	if (player.ai)
+	{
+		// reage a cada 0.1s de jogo
+		constexpr int ai_interval = gvar::tick_rate / 10;
+
+		if (--player.aiWait <= 0) {
+			player.aiWait = ai_interval;
+
+			const auto offset = ball.pos - player.pos;
+			const auto ai_speed = 1;
+			const auto ydiff = abs(offset.y);
+
+			if (ydiff >= ball.radius) {
+				mom.y += std::copysign(ai_speed, offset.y);
+				turbo = ydiff > 99;
+			}
+		}
+	}
+	else // player
+	{
+		// keyboard
+		if (in.up)
+			mom.y -= g.paddle_kb_speed;
+		else if (in.down)
+			mom.y += g.paddle_kb_speed;
+
+		// joystick
+		if (in.joystick)
+			mom.y = in.axis / 3;
+
+		turbo = in.fast;
+	}
+
+	// TODO: mover pra player.update()
+	mom.y = std::clamp(mom.y, -paddle_max_speed, paddle_max_speed);
+
+	if (turbo)
+	{
+		mom.y *= 1.25f;
+	}
+	else if (!player.ai && player.vel == mom) {
+		mom.y *= 0.6f;
+	}
+
+	player.vel = mom;
+	player.update();
+
+	// bateu numa parede/obstáculo: para e encosta do lado de onde veio
+	court.map->solids.query(player.bounds(), [&](const rect& wall) {
+		player.vel = {};
+
+		if (player.pos.y > wall.top + wall.height / 2) {
+			player.pos.y = wall.top + wall.height + g.paddle_height / 2 + 2;
+		}
+		else {
+			player.pos.y = wall.top - g.paddle_height / 2 - 2;
+		}
+	});
+
+}
+
+template<class G>
+void pong::match::updateBall(const G& g)
+{
+	player_t* player = nullptr;
+	auto mom = ball.vel;
+	const auto bounds = ball.bounds();
+
+	if (collision(bounds, player1.bounds())) {
+		player = &player1;
+	}
+	else if (collision(bounds, player2.bounds())) {
+		player = &player2;
+	}
+
+	if (player)
+	{
+		const auto ball_max_speed = g.ball_max_speed;
+
+		mom.x += g.ball_acceleration;
+		mom.y += player->vel.y * 0.5f;
+
+		ball.vel = {
+			-std::clamp(mom.x, -ball_max_speed, ball_max_speed),
+			 std::clamp(mom.y, -ball_max_speed, ball_max_speed)
+		};
+
+		const auto offset = (ball.pos.y - player->pos.y) / (g.paddle_height / 2);
+		physEvents.push({ phys_event::paddle_hit, player->id, 0, ball.pos, ball.vel, offset });
+
+		const auto paddle = player->bounds();
+		do
+		{
+			ball.update();
+		} while (collision(paddle, ball.bounds()));
+	}
+	else ball.update();
+
+	court.map->solids.query(ball.bounds(), [&](const rect& wall) {
+		// sai pelo eixo em que entrou menos; só rebate se ainda estiver indo
+		// pra dentro da parede
+		const auto b = ball.bounds();
+		const float dx = std::min(b.left + b.width - wall.left, wall.left + wall.width - b.left);
+		const float dy = std::min(b.top + b.height - wall.top, wall.top + wall.height - b.top);
+		const float cx = wall.left + wall.width / 2, cy = wall.top + wall.height / 2;
+
+		if (dy <= dx)
+		{
+			const float away = ball.pos.y < cy ? -1.f : 1.f;
+			if (ball.vel.y * away >= 0)
+				return;
+			ball.vel.y = -ball.vel.y;
+		}
+		else
+		{
+			const float away = ball.pos.x < cx ? -1.f : 1.f;
+			if (ball.vel.x * away >= 0)
+				return;
+			ball.vel.x = -ball.vel.x;
+		}
+		physEvents.push({ phys_event::wall_bounce, {}, 1, ball.pos, ball.vel });
+	});
+
+	checkGoal();
+}
+
+void pong::match::checkGoal()
+{
+	const auto bounds = ball.bounds();
+
+	// zonas todas fora da quadra: a bola ainda encostando nela não fez gol
+	if (!court.map->goalsInside && collision(rect({}, court.size), bounds))
+		return;
+
+	const goal_zone* zone = nullptr;
+	for (auto& g : court.map->goals) {
+		if (contains(g.area, bounds)) {
+			zone = &g;
+			break;
+		}
+	}
+	if (!zone)
+		return;
+
+	// instante exato em que a bola entrou toda na zona
+	const auto r = ball.radius;
+	const auto pos = ball.pos;
+	const auto vel = ball.vel;
+	const auto prevX = pos.x - vel.x;
+	float t = 1;
+
+	if (vel.x < 0) {
+		t = (zone->area.left + zone->area.width - (prevX + r)) / vel.x;
+	}
+	else if (vel.x > 0) {
+		t = (zone->area.left - (prevX - r)) / vel.x;
+	}
+
+	physEvents.push({ phys_event::goal, zone->scorer, std::clamp(t, 0.f, 1.f), pos, vel });
+}
+
+void pong::match::updateScore(const phys_event& goal)
+{
+	if (goal.player == playerid::one)
+	{
+		// saiu pela direita, saque pra direita
+		score.first++;
+		serveDir = dir::right;
+	}
+	else
+	{
+		// saiu pela esquerda, saque pra esquerda
+		score.second++;
+		serveDir = dir::left;
+	}
+
+	emit(telemetry::event_type::point, std::uint8_t(goal.player), std::uint16_t(rally),
+		float(score.first), float(score.second));
+	lastRally = std::exchange(rally, 0);
+	if (!muted) {
+		PONG_LOG_INFO("score: {}x{} ; serve: {} ; tick {:.2f}", score.first, score.second,
+			binlog::tag(conv::to_string_view(serveDir)), double(tick) + goal.time);
+	}
+}
+
+void pong::match::processPhysEvents()
+{
+	bool goal = false;
+
+	for (auto& ev : physEvents)
+	{
+		switch (ev.kind)
+		{
+		case phys_event::paddle_hit:
+			rally++;
+			emit(telemetry::event_type::paddle_hit, std::uint8_t(ev.player), 0,
+				ev.offset, ev.vel.x, ev.vel.y);
+			break;
+		case phys_event::wall_bounce:
+			emit(telemetry::event_type::wall_bounce, 0, 0, ev.pos.x, ev.pos.y, ev.vel.x, ev.vel.y);
+			break;
+		case phys_event::goal:
+			updateScore(ev);
+			goal = true;
+			break;
+		}
+	}
+
+	if (goal)
+	{
+		reset(player1);
+		reset(player2);
+		reset(ball);
+	}
+}
+
+void pong::match::step()
+{
+	physEvents.clear();
+
+	if ((input.players[0].serve || input.players[1].serve) && waiting_to_serve()) {
+		serve(serveDir);
+	}
+
+	// perfil padrão: G = builtin_guts, as constantes entram dobradas
+	if (builtin)
+		stepWith(pong::builtin_guts{});
+	else
+		stepWith(profile);
+
+	processPhysEvents();
+	tick++;
+}
+
+template<class G>
+void pong::match::stepWith(const G& g)
+{
+	updatePlayer(player1, input.players[0], g);
+	updatePlayer(player2, input.players[1], g);
+	updateBall(g);
+}
+
+
+void pong::match::reset()
+{
+	reset(player1);
+	reset(player2);
+	reset(ball);
+
+	score = {};
+	rally = lastRally = 0;
+}
+
+void pong::match::reset(ball_t& b)
+{
+	b.vel = {};
+	b.pos = { gvar::playarea_width / 2, gvar::playarea_height / 2 };
+}
+
+void pong::match::reset(player_t& p)
+{
+	const auto center = point(gvar::playarea_width / 2, gvar::playarea_height / 2);
+	const auto margin = 10;
+
+	if (p.id == playerid::one) {
+		p.pos = { profile.paddle_width + margin, center.y };
+	}
+	else if (p.id == playerid::two) {
+		p.pos = { gvar::playarea_width - (profile.paddle_width + margin), center.y };
+	}
+
+	p.vel = {};
+	p.aiWait = 0;
+}
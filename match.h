@@ -0,0 +1,227 @@
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <type_traits>
+#include "arena.h"
+#include "common.h"
+#include "guts.h"
+#include "phys_events.h"
+#include "rng.h"
+#include "telemetry.h"
+
+namespace pong
+{
+	enum struct gamemode { singleplayer, multiplayer, aitest };
+
+	// corpos da simulação: só números, sem transform. As sf::Shape ficam no
+	// render e são sincronizadas a partir do match_frame
+	struct box_body
+	{
+		point pos;
+		vec2 vel;
+		rect box; // caixa de colisão, relativa a pos
+
+		void update() noexcept { pos += vel; }
+
+		rect bounds() const noexcept {
+			return { pos.x + box.left, pos.y + box.top, box.width, box.height };
+		}
+	};
+
+	struct circle_body
+	{
+		point pos; // centro
+		vec2 vel;
+		float radius = 0;
+
+		void update() noexcept { pos += vel; }
+
+		rect bounds() const noexcept {
+			return { pos.x - radius, pos.y - radius, 2 * radius, 2 * radius };
+		}
+	};
+
+	// pos: meio da borda esquerda da raquete
+	struct player_t : box_body
+	{
+		player_t(playerid pid);
+
+		// caixa pra uma raquete width x height, com o contorno
+		void resize(float width, float height) noexcept;
+
+		point previewPos() const {
+			return pos + vel;
+		}
+
+		playerid id;
+		bool ai = false;
+		int aiWait = 0; // ticks até a IA reagir de novo
+	};
+
+	struct ball_t : circle_body
+	{
+		ball_t();
+	};
+
+	// geometria da quadra, sem nada de render
+	struct court_t
+	{
+		size2d size;
+		rect top, bottom; // bordas
+		std::shared_ptr<const arena> map; // paredes/obstáculos (BVH) e gols
+
+		bool border_collision(const rect& bounds) const {
+			return map->solids.any(bounds);
+		}
+
+		float topInner() const { return top.top + top.height; }
+		float bottomInner() const { return bottom.top; }
+
+		static court_t from(std::shared_ptr<const arena> map);
+		// mesma geometria do background, sem precisar de um
+		static court_t standard(size2d area);
+	};
+
+	// input de um jogador, amostrado na main thread
+	struct player_input
+	{
+		float axis = 0; // joystick, só vale com joystick = true
+		bool up = false, down = false, fast = false;
+		bool joystick = false; // eixo fora da deadzone
+		bool serve = false; // netplay: o saque vai junto do input
+
+		bool operator==(const player_input&) const = default;
+	};
+
+	struct tick_input
+	{
+		player_input players[2];
+	};
+
+	// estado completo da partida, de tamanho fixo e trivialmente copiável:
+	// salvar/restaurar é uma cópia. Base pra rollback, run-ahead e replays
+	struct game_state
+	{
+		struct paddle_t
+		{
+			point pos;
+			vec2 vel;
+			std::int32_t aiWait;
+			bool ai;
+		};
+
+		paddle_t paddles[2];
+		point ballPos;
+		vec2 ballVel;
+		tick_input input; // último input recebido, vale até chegar outro
+		std::int32_t score[2];
+		std::int32_t rally, lastRally;
+		std::uint64_t tick;
+		std::uint64_t rng; // chave do squares; o contador sai de tick
+		dir serveDir;
+		bool paused;
+	};
+	static_assert(std::is_trivially_copyable_v<game_state>);
+
+	// hash campo a campo (padding não entra), estável entre builds
+	std::uint64_t hash(const game_state& state) noexcept;
+
+	// mensagens pra simulação, na ordem em que devem ser aplicadas
+	struct sim_message
+	{
+		enum kind_t : std::uint8_t { input, serve, reset, mode, pause, resume, toggle_ai } kind = input;
+		std::uint8_t arg = 0; // mode: gamemode; toggle_ai: playerid
+		tick_input in;
+	};
+
+	// o que o render e o overlay precisam de um tick
+	struct match_frame
+	{
+		std::uint64_t tick = 0;
+		point pos[2], ballPos;
+		vec2 vel[2], ballVel;
+		pair<int> score;
+		int rally = 0, lastRally = 0; // rebatidas no ponto atual e no anterior
+		bool ai[2] = {};
+		bool paused = true;
+	};
+
+	// a partida em si: física, placar e regras. Não mexe com janela nem input
+	// do sistema, então pode rodar em qualquer thread
+	class match
+	{
+	public:
+		// seed: id da partida, vira a chave do RNG
+		explicit match(court_t court, std::uint64_t seed = 1337, const physics_profile& guts = {});
+
+		// outra partida no mesmo objeto, igual a construir de novo com a
+		// mesma quadra. Batch e sweep reaproveitam um match por thread
+		void rematch(std::uint64_t seed, const physics_profile& guts);
+
+		void apply(const sim_message& msg);
+		void step();
+
+		match_frame frame() const noexcept;
+
+		void save(game_state& out) const noexcept;
+		void restore(const game_state& in) noexcept;
+		game_state state() const noexcept {
+			game_state s;
+			save(s);
+			return s;
+		}
+
+		bool waiting_to_serve() const noexcept;
+		bool paused() const noexcept { return isPaused; }
+
+		// sem telemetria nem log: ticks re-simulados ou especulativos
+		void mute(bool value) noexcept { muted = value; }
+		std::uint64_t ticks() const noexcept { return tick; }
+
+		// sorteios do tick atual. Só depende do snapshot: rollback, run-ahead
+		// e partidas em paralelo sorteiam sempre os mesmos números
+		rng_stream random() const noexcept { return { rng, tick }; }
+
+		// eventos do último tick
+		auto& events() const noexcept { return physEvents; }
+
+		const physics_profile& guts() const noexcept { return profile; }
+		// perfil igual ao compilado: física com constantes
+		bool compiled_guts() const noexcept { return builtin; }
+
+		player_t player1{ playerid::one }, player2{ playerid::two };
+		ball_t ball;
+
+	private:
+		court_t court;
+		physics_profile profile;
+		bool builtin;
+		tick_input input;
+		bool isPaused = true;
+		pair<int> score;
+		dir serveDir = dir::left;
+		int rally = 0, lastRally = 0;
+		std::uint64_t tick = 0;
+		std::uint64_t rng; // chave do RNG da partida, vai junto no snapshot
+
+		event_queue<64> physEvents;
+		bool muted = false;
+
+		void emit(telemetry::event_type type, std::uint8_t player = 0, std::uint16_t data = 0,
+			float f0 = 0, float f1 = 0, float f2 = 0, float f3 = 0) const noexcept;
+
+		void changeMode(gamemode m) noexcept;
+		void serve(dir direction);
+		void reset();
+		void reset(player_t& player);
+		void reset(ball_t& ball);
+
+		// G: builtin_guts (constexpr) ou physics_profile
+		template<class G> void stepWith(const G& g);
+		template<class G> void updatePlayer(player_t& player, const player_input& in, const G& g);
+		template<class G> void updateBall(const G& g);
+		void checkGoal();
+		void processPhysEvents();
+		void updateScore(const phys_event& goal);
+	};
+}
@@ -2,11 +2,16 @@
 #include "convert.h"
 #include "game.h"
 #include "imgui_inc.h"
+#include "startup.h"
+#include "font_cache.h"
+#include "gvar.h"
 
 #include <algorithm>
 #include <optional>
 #include <vector>
 #include <sstream>
+#include <utility>
+#include <cfloat>
 
 #include <imgui-SFML.h>
 #include <fmt/ostream.h>
@@ -87,30 +92,125 @@ namespace
 
 using namespace pong;
 
+namespace
+{
+	// só o que os textos do menu usam
+	const ImWchar latin1_ranges[] = { 0x0020, 0x00FF, 0 };
+	const ImWchar ascii_ranges[] = { 0x0020, 0x007E, 0 };
+}
+
+void themenu::prefetch()
+{
+	fontsTask = std::async(std::launch::async, [this] {
+		startup::scoped_phase _p_("themenu.font_atlas");
+		load_fonts();
+	});
+}
+
+void themenu::load_fonts()
+{
+	// ordem das fontes no atlas
+	const int order[font_count] = { font_normal, font_larger, font_title, font_monospace };
+	const font_cache::font_desc desc[font_count] = {
+		{ pong::files::sans_tff, font_size, latin1_ranges },
+		{ pong::files::sans_tff, font_size * 2, ascii_ranges },
+		{ pong::files::sans_tff, font_size * 1.25f, ascii_ranges },
+		{ pong::files::mono_tff, font_size, ascii_ranges },
+	};
+
+	atlas = IM_NEW(ImFontAtlas)();
+	atlas->Flags |= ImFontAtlasFlags_NoBakedLines | ImFontAtlasFlags_NoMouseCursors;
+
+	const auto key = font_cache::make_key(desc);
+	const auto cacheFile = font_cache::file_for(key);
+
+	if (key && font_cache::load(cacheFile, key, *atlas))
+	{
+		spdlog::debug("font atlas from cache: {}", cacheFile.string());
+	}
+	else
+	{
+		for (auto& d : desc) {
+			atlas->AddFontFromFileTTF(d.path, d.size, nullptr, d.ranges);
+		}
+
+		unsigned char* pixels;
+		int width, height;
+		atlas->GetTexDataAsAlpha8(&pixels, &width, &height);
+
+		if (key && !font_cache::save(cacheFile, key, *atlas)) {
+			spdlog::warn("failed to write font cache {}", cacheFile.string());
+		}
+	}
+
+	for (int i = 0; i < font_count; i++) {
+		fonts[order[i]] = atlas->Fonts[i];
+	}
+
+	// converte aqui pra UpdateFontTexture() só fazer o upload
+	unsigned char* pixels;
+	int width, height;
+	atlas->GetTexDataAsRGBA32(&pixels, &width, &height);
+}
+
 void themenu::init()
 {
 	work_settings = game.settings;
 
-	if (!ImGui::SFML::Init(game.window, false)) {
-		spdlog::error("ImGui::SFML::Init failed!");
-		std::terminate();
+	{
+		startup::scoped_phase _p_("imgui.init");
+		if (!ImGui::SFML::Init(game.window, false)) {
+			spdlog::error("ImGui::SFML::Init failed!");
+			std::terminate();
+		}
 	}
 	
 	refresh_joysticks();
-	auto* atlas = ImGui::GetIO().Fonts;
 
-	atlas->Clear();
-	fonts[font_normal] = atlas->AddFontFromFileTTF(pong::files::sans_tff, font_size);
-	fonts[font_larger] = atlas->AddFontFromFileTTF(pong::files::sans_tff, font_size * 2);
-	fonts[font_title] = atlas->AddFontFromFileTTF(pong::files::sans_tff, font_size * 1.25f);
-	fonts[font_monospace] = atlas->AddFontFromFileTTF(pong::files::mono_tff, font_size);
+	// contexto assume o atlas pronto
+	auto& io = ImGui::GetIO();
+	IM_DELETE(io.Fonts);
+	io.Fonts = std::exchange(atlas, nullptr);
 
+	startup::scoped_phase _p_("imgui.update_font_texture");
 	if (!ImGui::SFML::UpdateFontTexture()) {
 		spdlog::error("ImGui::SFML::UpdateFontTexture failed!");
 		std::terminate();
 	}
 }
 
+bool themenu::ensure_init()
+{
+	if (initialized)
+		return true;
+
+	if (fontsTask.valid())
+	{
+		// não trava o frame esperando o atlas
+		if (fontsTask.wait_for(0s) != std::future_status::ready)
+			return false;
+		fontsTask.get();
+	}
+	else load_fonts();
+
+	init();
+	initialized = true;
+	return true;
+}
+
+bool themenu::idle() const
+{
+	// o popup de rebind lê o teclado direto, sem eventos
+	return initialized
+		&& !visible[ui_rebiding_popup]
+		&& !ImGui::IsAnyItemActive();
+}
+
+bool themenu::wanted() const noexcept
+{
+	return game.paused || visible[ui_game_stats];
+}
+
 themenu::themenu(pong::game& gameref, float fontsize)
 	: game(gameref)
 	, font_size(fontsize)
@@ -120,7 +220,13 @@ themenu::themenu(pong::game& gameref, float fontsize)
 
 themenu::~themenu()
 {
-	ImGui::SFML::Shutdown(game.window);
+	if (initialized)
+		ImGui::SFML::Shutdown(game.window);
+
+	if (fontsTask.valid())
+		fontsTask.wait();
+	if (atlas)
+		IM_DELETE(atlas);
 }
 
 bool themenu::isOpen(menuid mid)
@@ -132,7 +238,8 @@ void themenu::processEvent(sf::Event &event)
 {
 	using sf::Event;
 
-	ImGui::SFML::ProcessEvent(event);
+	if (initialized)
+		ImGui::SFML::ProcessEvent(event);
 
 	switch (event.type)
 	{
@@ -150,7 +257,8 @@ void themenu::processEvent(sf::Event &event)
 
 void themenu::render()
 {
-	ImGui::SFML::Render(game.window);
+	if (active)
+		ImGui::SFML::Render(game.window);
 }
 
 void themenu::update(sf::Time delta)
@@ -158,6 +266,10 @@ void themenu::update(sf::Time delta)
 	using namespace ImGui;
 	using namespace ImScoped;
 
+	active = wanted() && ensure_init();
+	if (!active)
+		return;
+
 	ImGui::SFML::Update(game.window, delta);
 
 
@@ -181,7 +293,7 @@ void themenu::update(sf::Time delta)
 
 			if (auto m = Menu("Jogo")) {
 				if (MenuItem("Continuar", "ESC"))
-					game.paused = false;
+					game.setPaused(false);
 				if (auto m1 = Menu("Novo")) {
 
 					if (MenuItem("1 jogador", nullptr, game.mode == gamemode::singleplayer)) {
@@ -193,7 +305,7 @@ void themenu::update(sf::Time delta)
 				}
 				if (MenuItem("Reiniciar")) {
 					game.reset();
-					game.paused = false;
+					game.setPaused(false);
 				}
 				Separator();
 				MenuItem("Sobre", nullptr, &visible[ui_about]);
@@ -255,6 +367,7 @@ void themenu::optionsUi()
 						ImGui::SetItemDefaultFocus();
 				}
 			}
+			ImGui::Checkbox("Tela cheia", &work_settings.fullscreen);
 		}
 		if (auto tab = gui::TabBarItem("Controles"))
 		{
@@ -285,14 +398,40 @@ void themenu::optionsUi()
 	ImGui::SameLine();
 	if (ImGui::Button("Salvar") && isDirty)
 	{
+		const bool video = work_settings.resolution != game.settings.resolution
+			|| work_settings.fullscreen != game.settings.fullscreen;
 		game.settings = work_settings;
-		// TODO: resolução
+		if (video) {
+			game.applyVideoSettings();
+		}
 	}
 }
 
+// formata no buffer, sem alocar
+template<size_t N, class... Args>
+static auto format_buf(char (&buf)[N], fmt::format_string<Args...> fmtstr, Args&&... args) -> const char*
+{
+	auto r = fmt::format_to_n(buf, N - 1, fmtstr, std::forward<Args>(args)...);
+	*r.out = '\0';
+	return buf;
+}
+
+template<class Ring>
+static void plot_history(const char* label, const Ring& values, float min, float max)
+{
+	char overlay[32];
+	format_buf(overlay, "{:.2f}", values.empty() ? 0.f : values.back());
+
+	ImGui::PlotLines(label, values.data(), int(values.size()), int(values.offset()),
+		overlay, min, max, { 220, 40 });
+}
+
 void themenu::gameStatsUi()
 {
 	namespace ims = ImScoped;
+	const auto& guts = game.sim.guts();
+	const float ball_max_speed = guts.ball_max_speed;
+	const float paddle_max_speed = guts.paddle_max_speed;
 
 	ImGuiIO& io = ImGui::GetIO();
 	pos winpos = { io.DisplaySize.x - 10.f, 15.f };
@@ -303,20 +442,106 @@ void themenu::gameStatsUi()
 						| ImGuiWindowFlags_NoFocusOnAppearing | ImGuiWindowFlags_NoNav;
 	ims::Window overlay("Stats", &visible[ui_game_stats], wflags);
 
-	point Pos[] = {
-		game.player1.shape.getPosition(),
-		game.player2.shape.getPosition(),
-		game.ball.shape.getPosition()
-	};
+	auto& stats = game.stats;
+	auto& frame = game.frame;
+	char text[128];
 
-	auto text = fmt::format("P1: [{:.2f}]\n" "P2: [{:.2f}]\n" "Ball: [{:.2f}]", Pos[0], Pos[1], Pos[2]);
+	format_buf(text, "P1: [{:.2f}]\n" "P2: [{:.2f}]\n" "Ball: [{:.2f}]",
+		frame.pos[0], frame.pos[1], frame.ballPos);
+	ImGui::Text("Positions:\n%s", text);
 
-	ImGui::Text("Positions:\n%s", text.c_str());
+	format_buf(text, "P1: {:.3f}\nP2: {:.3f}\nBall: [{:.2f}]",
+		frame.vel[0], frame.vel[1], frame.ballVel);
+	ImGui::Text("Velocity:\n%s", text);
 
-	text = fmt::format("P1: {:.3f}\nP2: {:.3f}\nBall: [{:.2f}]", 
-		game.player1.velocity, game.player2.velocity, game.ball.velocity);
-
-	ImGui::Text("Velocity:\n%s", text.c_str());
+	ImGui::Separator();
+	// a velocidade da bola não passa de max * sqrt(2)
+	plot_history("Ball speed", stats.ballSpeed, 0, ball_max_speed * 1.5f);
+	plot_history("P1 vel.", stats.p1Speed, -paddle_max_speed * 1.25f, paddle_max_speed * 1.25f);
+	plot_history("P2 vel.", stats.p2Speed, -paddle_max_speed * 1.25f, paddle_max_speed * 1.25f);
+
+	ImGui::Text("Rally: %d", frame.rally);
+	ImGui::Text("Física: %s", game.sim.compiled_guts() ? "padrão (compilada)" : "perfil carregado");
+	if (!game.simulation() && !game.network() && !game.watching())
+	{
+		// input -> display() medido, +1 refresh até aparecer na tela,
+		// menos o que o run-ahead adianta
+		const float tickMs = 1000.f / gvar::tick_rate;
+		const float lag = stats.inputLag.empty() ? 0 : stats.inputLag.back();
+		const float ahead = game.runAhead * tickMs;
+		ImGui::Separator();
+		// com bolas extras ou party o run-ahead fica desligado (ver o construtor)
+		if (game.supportsRunAhead()) {
+			ImGui::SliderInt("Run-ahead", &game.runAhead, 0, game.max_run_ahead);
+		}
+		ImGui::Text("Latência: ~%.1f ms (input -> display %.1f ms, run-ahead -%.1f ms)",
+			std::max(lag + tickMs - ahead, 0.f), lag, ahead);
+		plot_history("Input lag", stats.inputLag, 0, tickMs * 2);
+	}
+	if (auto* simThread = game.simulation()) {
+		ImGui::Text("Tick: %llu (%llu dropped)", (unsigned long long)frame.tick,
+			(unsigned long long)simThread->dropped());
+	}
+	if (auto* net = game.network())
+	{
+		auto& ns = net->stats();
+		ImGui::Separator();
+		if (!net->connected()) {
+			ImGui::TextUnformatted("Netplay: esperando o outro jogador...");
+		}
+		else
+		{
+			ImGui::Text("Netplay: tick %u, %d previstos, rtt %.0f ms", net->tick(), net->predicted(), ns.rttMs);
+			ImGui::Text("Rollbacks: %llu (%llu ticks, max %d)", (unsigned long long)ns.rollbacks,
+				(unsigned long long)ns.resimTicks, ns.maxDepth);
+			ImGui::Text("Re-sim: %.0f us (max %.0f us)", ns.lastResimUs, ns.maxResimUs);
+			ImGui::Text("Stalls: %llu  Desyncs: %llu", (unsigned long long)ns.stalls, (unsigned long long)ns.desyncs);
+			ImGui::Text("Pacotes: %llu enviados, %llu recebidos, %llu perdidos", (unsigned long long)ns.sent,
+				(unsigned long long)ns.received, (unsigned long long)ns.dropped);
+		}
+	}
+	if (auto* balls = game.multiball())
+	{
+		auto& ms = balls->stats();
+		const auto goals = balls->goals();
+		ImGui::Separator();
+		ImGui::Text("Multibola: %zu bolas (r %.1f), gols %d x %d", balls->balls().size(), balls->radius(),
+			goals.first, goals.second);
+		ImGui::Text("Física: %.0f us, grade %.0f us, colisões %.0f us", ms.integrateUs, ms.broadphaseUs, ms.narrowphaseUs);
+		ImGui::Text("Pares: %u, contatos: %u", ms.pairs, ms.contacts);
+	}
+	if (auto* party = game.partyMode())
+	{
+		const auto conceded = party->conceded();
+		ImGui::Separator();
+		ImGui::Text("Festa: %d jogadores, %zu bolas, tick %llu", party->players_count(), party->balls().size(),
+			(unsigned long long)party->ticks());
+		for (std::size_t i = 0; i < conceded.size(); i++) {
+			ImGui::Text("  Player %zu: %d gols sofridos", i + 1, conceded[i]);
+		}
+	}
+	if (auto* fx = game.effects())
+	{
+		ImGui::Separator();
+		ImGui::Text("Partículas: %zu / %zu, %.0f us, %llu descartadas", fx->size(), fx->capacity(), fx->updateUs(),
+			(unsigned long long)fx->dropped());
+	}
+	if (auto* caster = game.broadcasting())
+	{
+		ImGui::Separator();
+		ImGui::Text("Transmissão: %d espectadores, %.1f kB enviados", caster->subscribers(),
+			caster->bytesSent() / 1024.0);
+	}
+	if (auto* watcher = game.watching())
+	{
+		auto& ws = watcher->stats();
+		ImGui::Separator();
+		ImGui::Text("Assistindo: tick %u, desenhando %.1f", ws.latestTick, ws.renderTick);
+		ImGui::Text("Pacotes: %llu recebidos, %llu perdidos, %llu frames sem estado",
+			(unsigned long long)ws.packets, (unsigned long long)ws.lost, (unsigned long long)ws.waiting);
+	}
+	ImGui::PlotHistogram("Rallies", stats.rallies.data(), int(stats.rallies.size()), int(stats.rallies.offset()),
+		nullptr, 0, FLT_MAX, { 220, 40 });
 }
 
 void themenu::aboutUi()
@@ -405,6 +630,7 @@ void themenu::controlsUi()
 					curKey = key.value();
 
 				CloseCurrentPopup();
+				visible[ui_rebiding_popup] = false;
 			}
 		}
 	};
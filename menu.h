@@ -1,6 +1,7 @@
 #pragma once
 #include "game_config.h"
 #include <array>
+#include <future>
 
 namespace sf {
 	class Event;
@@ -14,6 +15,7 @@ namespace pong {
 };
 
 class ImFont;
+struct ImFontAtlas;
 
 
 class themenu
@@ -24,7 +26,15 @@ public:
 
 	~themenu();
 
-	void init();
+	// começa a montar o atlas de fontes numa worker thread.
+	// ImGui só é inicializado quando o menu aparece pela 1a vez
+	void prefetch();
+
+	// algo do menu precisa ser mostrado?
+	bool wanted() const noexcept;
+	bool ready() const noexcept { return initialized; }
+	// nada animando nem esperando input fora de eventos
+	bool idle() const;
 
 	enum menuid {
 		ui_options,
@@ -45,6 +55,12 @@ public:
 
 private:
 
+	// monta o atlas de fontes (cache em disco ou rasterizando)
+	void load_fonts();
+	// inicializa ImGui, precisa do atlas de load_fonts()
+	void init();
+	bool ensure_init();
+
 	void optionsUi();
 	void aboutUi();
 	void gameStatsUi();
@@ -62,6 +78,9 @@ private:
 		font_count
 	};
 	std::array<ImFont*, font_count> fonts;
+	ImFontAtlas* atlas = nullptr;
+	std::future<void> fontsTask;
+	bool initialized = false, active = false;
 	float font_size;
 };
 
@@ -0,0 +1,88 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace util
+{
+    // fila MPMC limitada, sem locks (Vyukov). N precisa ser potência de 2.
+    // push() falha em vez de bloquear quando está cheia
+    template<class T, std::size_t N>
+    class mpmc_queue
+    {
+        static_assert(N >= 2 && (N & (N - 1)) == 0, "N precisa ser potência de 2");
+
+    public:
+        mpmc_queue() noexcept
+        {
+            for (std::size_t i = 0; i < N; i++)
+                cells[i].seq.store(i, std::memory_order_relaxed);
+        }
+
+        mpmc_queue(const mpmc_queue&) = delete;
+
+        bool push(const T& value) noexcept
+        {
+            cell* c;
+            auto pos = enqueuePos.load(std::memory_order_relaxed);
+            for (;;)
+            {
+                c = &cells[pos & (N - 1)];
+                auto seq = c->seq.load(std::memory_order_acquire);
+                auto dif = std::intptr_t(seq) - std::intptr_t(pos);
+
+                if (dif == 0) {
+                    if (enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                        break;
+                }
+                else if (dif < 0)
+                    return false; // cheia
+                else
+                    pos = enqueuePos.load(std::memory_order_relaxed);
+            }
+
+            c->data = value;
+            c->seq.store(pos + 1, std::memory_order_release);
+            return true;
+        }
+
+        bool pop(T& value) noexcept
+        {
+            cell* c;
+            auto pos = dequeuePos.load(std::memory_order_relaxed);
+            for (;;)
+            {
+                c = &cells[pos & (N - 1)];
+                auto seq = c->seq.load(std::memory_order_acquire);
+                auto dif = std::intptr_t(seq) - std::intptr_t(pos + 1);
+
+                if (dif == 0) {
+                    if (dequeuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                        break;
+                }
+                else if (dif < 0)
+                    return false; // vazia
+                else
+                    pos = dequeuePos.load(std::memory_order_relaxed);
+            }
+
+            value = c->data;
+            c->seq.store(pos + N, std::memory_order_release);
+            return true;
+        }
+
+        static constexpr std::size_t capacity() noexcept { return N; }
+
+    private:
+        struct cell
+        {
+            std::atomic<std::size_t> seq;
+            T data;
+        };
+
+        std::array<cell, N> cells;
+        alignas(64) std::atomic<std::size_t> enqueuePos{ 0 };
+        alignas(64) std::atomic<std::size_t> dequeuePos{ 0 };
+    };
+}
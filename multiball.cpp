@@ -0,0 +1,240 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include "multiball.h"
+#include "gvar.h"
+
+namespace
+{
+	using clock = std::chrono::steady_clock;
+
+	double us_since(clock::time_point start) noexcept
+	{
+		return std::chrono::duration<double, std::micro>(clock::now() - start).count();
+	}
+
+	float dot(pong::vec2 a, pong::vec2 b) noexcept { return a.x * b.x + a.y * b.y; }
+}
+
+pong::ball_field::ball_field(const court_t& court_, rect area_, std::size_t capacity, float radius,
+	std::uint64_t seed, const physics_profile& guts)
+	: court(court_), profile(guts)
+	, solids(court_.map->walls.size() > 2 || !court_.map->obstacles.empty())
+	, area(area_), r(radius), key(squares::key(seed))
+{
+	pool.reserve(capacity);
+	sorted.reserve(capacity);
+	ballCell.resize(capacity);
+	cellBalls.resize(capacity);
+
+	// célula = diâmetro: quem encosta está no máximo uma célula ao lado
+	const float cell = 2 * r;
+	invCell = 1 / cell;
+	cols = std::max(1, int(std::ceil(area.width * invCell)));
+	rows = std::max(1, int(std::ceil(area.height * invCell)));
+	cellStart.resize(std::size_t(cols) * rows + 1);
+}
+
+float pong::ball_field::radius_for(rect area, std::size_t n, float maxRadius, float fill) noexcept
+{
+	constexpr float pi = 3.14159265f;
+	const auto fit = std::sqrt(area.width * area.height * fill / (pi * std::max<std::size_t>(n, 1)));
+	return std::clamp(fit, std::min(2.f, maxRadius), maxRadius);
+}
+
+pong::ball_body pong::ball_field::launch(rng_stream& dice) const noexcept
+{
+	// nunca muito vertical, senão fica quicando entre as paredes
+	const float angle = (dice.unit() - 0.5f) * 1.4f + (dice.coin() ? 3.14159265f : 0.f);
+	const float speed = profile.ball_speed * (0.75f + 0.5f * dice.unit());
+	return {
+		{ court.size.x / 2, (court.topInner() + court.bottomInner()) / 2 },
+		{ std::cos(angle) * speed, std::sin(angle) * speed }
+	};
+}
+
+void pong::ball_field::spawn(std::size_t n)
+{
+	auto dice = rng_stream(key, tick);
+	n = std::min(n, pool.capacity() - pool.size());
+
+	// espalha um pouco em volta do centro pra não nascerem todas sobrepostas
+	for (std::size_t i = 0; i < n; i++)
+	{
+		auto b = launch(dice);
+		b.pos.x += (dice.unit() - 0.5f) * area.width * 0.5f;
+		b.pos.y += (dice.unit() - 0.5f) * area.height * 0.8f;
+		pool.push_back(b);
+	}
+	tick++;
+}
+
+int pong::ball_field::cell_of(point p) const noexcept
+{
+	const int cx = std::clamp(int((p.x - area.left) * invCell), 0, cols - 1);
+	const int cy = std::clamp(int((p.y - area.top) * invCell), 0, rows - 1);
+	return cy * cols + cx;
+}
+
+void pong::ball_field::step(const rect& paddle1, const rect& paddle2)
+{
+	st.pairs = st.contacts = 0;
+	auto dice = rng_stream(key, tick++);
+
+	auto start = clock::now();
+	const float top = court.topInner() + r, bottom = court.bottomInner() - r;
+
+	for (auto& b : pool)
+	{
+		b.pos += b.vel;
+
+		if (b.pos.y < top) {
+			b.pos.y = top;
+			b.vel.y = std::abs(b.vel.y);
+		}
+		else if (b.pos.y > bottom) {
+			b.pos.y = bottom;
+			b.vel.y = -std::abs(b.vel.y);
+		}
+
+		// paredes extras e obstáculos; as bordas já foram acima
+		if (solids)
+		{
+			court.map->solids.query({ b.pos.x - r, b.pos.y - r, 2 * r, 2 * r }, [&](const rect& wall) {
+				bounce(b.pos, { r, r }, b.vel, wall);
+			});
+		}
+
+		collide_paddle(b, paddle1);
+		collide_paddle(b, paddle2);
+
+		// saiu pela esquerda: ponto do player 2, e vice-versa
+		if (b.pos.x < -r || b.pos.x > court.size.x + r)
+		{
+			goalCount[b.pos.x < 0 ? 1 : 0]++;
+			b = launch(dice);
+		}
+	}
+	st.integrateUs = us_since(start);
+
+	start = clock::now();
+	build_grid();
+	st.broadphaseUs = us_since(start);
+
+	start = clock::now();
+	collide_balls();
+	st.narrowphaseUs = us_since(start);
+}
+
+void pong::ball_field::collide_paddle(ball_body& b, const rect& paddle) noexcept
+{
+	// ponto do retângulo mais perto do centro
+	const point closest = {
+		std::clamp(b.pos.x, paddle.left, paddle.left + paddle.width),
+		std::clamp(b.pos.y, paddle.top, paddle.top + paddle.height)
+	};
+	const auto d = b.pos - closest;
+	if (dot(d, d) >= r * r)
+		return;
+
+	// volta pro lado de onde veio, com o efeito da altura em que bateu
+	const float center = paddle.left + paddle.width / 2;
+	const float side = b.pos.x < center ? -1.f : 1.f;
+	const float offset = (b.pos.y - (paddle.top + paddle.height / 2)) / (paddle.height / 2);
+
+	// aceleração somada, como em match
+	const float maxSpeed = profile.ball_max_speed;
+	b.vel.x = side * std::min(std::abs(b.vel.x) + profile.ball_acceleration, maxSpeed);
+	b.vel.y = std::clamp(b.vel.y + offset * 2, -maxSpeed, maxSpeed);
+	b.pos.x = side < 0 ? paddle.left - r : paddle.left + paddle.width + r;
+}
+
+void pong::ball_field::build_grid()
+{
+	// counting sort por célula: conta, soma prefixada, distribui
+	std::fill(cellStart.begin(), cellStart.end(), 0);
+
+	const auto n = pool.size();
+	for (std::size_t i = 0; i < n; i++)
+	{
+		const auto c = std::uint32_t(cell_of(pool[i].pos));
+		ballCell[i] = c;
+		cellStart[c + 1]++;
+	}
+	for (std::size_t c = 1; c < cellStart.size(); c++) {
+		cellStart[c] += cellStart[c - 1];
+	}
+
+	// distribui de trás pra frente usando o fim de cada célula
+	for (std::size_t i = n; i-- > 0;) {
+		cellBalls[--cellStart[ballCell[i] + 1]] = std::uint32_t(i);
+	}
+	// depois do loop cellStart[c + 1] aponta pro início da célula c
+	std::rotate(cellStart.begin(), cellStart.begin() + 1, cellStart.end());
+	cellStart.back() = std::uint32_t(n);
+
+	// reordena o pool por célula: vizinhas ficam vizinhas na memória e a
+	// célula c vira simplesmente pool[cellStart[c] .. cellStart[c+1])
+	sorted.resize(n);
+	for (std::size_t k = 0; k < n; k++) {
+		sorted[k] = pool[cellBalls[k]];
+	}
+	pool.swap(sorted);
+}
+
+void pong::ball_field::collide_balls()
+{
+	const float minDist2 = 4 * r * r;
+
+	auto resolve = [&](std::uint32_t i, std::uint32_t j) {
+		st.pairs++;
+		auto& a = pool[i];
+		auto& b = pool[j];
+		const auto d = b.pos - a.pos;
+		const float dist2 = dot(d, d);
+		if (dist2 >= minDist2 || dist2 == 0)
+			return;
+
+		// massas iguais, elástica: troca a velocidade ao longo da normal
+		const float dist = std::sqrt(dist2);
+		const auto n = d / dist;
+		const float approach = dot(a.vel - b.vel, n);
+		if (approach > 0) {
+			a.vel -= n * approach;
+			b.vel += n * approach;
+		}
+
+		// separa as duas pela metade da sobreposição cada
+		const auto push = n * ((2 * r - dist) / 2);
+		a.pos -= push;
+		b.pos += push;
+		st.contacts++;
+	};
+
+	// cada par de células vizinhas uma vez só: a própria e 4 das 8 vizinhas.
+	// Anda pelas bolas (já em ordem de célula), não pelas células: a maioria
+	// das células fica vazia com muitas bolas pequenas
+	constexpr int forward[4][2] = { { 1, 0 }, { -1, 1 }, { 0, 1 }, { 1, 1 } };
+	const auto n = std::uint32_t(pool.size());
+
+	for (std::uint32_t k = 0; k < n; k++)
+	{
+		const auto c = ballCell[cellBalls[k]];
+		for (auto l = k + 1; l < cellStart[c + 1]; l++) {
+			resolve(k, l);
+		}
+
+		const int cx = int(c % cols), cy = int(c / cols);
+		for (auto [dx, dy] : forward)
+		{
+			const int nx = cx + dx, ny = cy + dy;
+			if (nx < 0 || nx >= cols || ny >= rows)
+				continue;
+
+			const int o = ny * cols + nx;
+			for (auto l = cellStart[o]; l < cellStart[o + 1]; l++) {
+				resolve(k, l);
+			}
+		}
+	}
+}
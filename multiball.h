@@ -0,0 +1,79 @@
+#pragma once
+// modo multibola: centenas/milhares de bolas extras, além da bola da partida.
+// Broadphase por grade uniforme (spatial hash) reconstruída a cada tick com
+// counting sort: sem alocação, e cada bola só testa as vizinhas nas 3x3
+// células em volta. Bolas vivem num pool reservado uma vez.
+#include <cstdint>
+#include <span>
+#include <vector>
+#include "common.h"
+#include "match.h"
+#include "rng.h"
+
+namespace pong
+{
+	struct ball_body
+	{
+		point pos;
+		vec2 vel;
+	};
+
+	struct multiball_stats
+	{
+		double broadphaseUs = 0, narrowphaseUs = 0, integrateUs = 0;
+		std::uint32_t pairs = 0, contacts = 0; // pares testados, colisões resolvidas
+	};
+
+	class ball_field
+	{
+	public:
+		// area: onde a grade cobre (background::innerBounds()); fora dela as
+		// bolas caem nas células da borda. guts: a física da partida
+		ball_field(const court_t& court, rect area, std::size_t capacity, float radius,
+			std::uint64_t seed = 1, const physics_profile& guts = {});
+
+		// raio pra n bolas ocuparem ~fill da área, no máximo maxRadius
+		static float radius_for(rect area, std::size_t n, float maxRadius = gvar::ball_radius, float fill = 0.15f) noexcept;
+
+		// no centro, direções sorteadas. Para no limite do pool
+		void spawn(std::size_t n);
+		void clear() noexcept { pool.clear(); }
+
+		// paredes, raquetes, bola x bola, gols. Bola que sai vira ponto e
+		// volta pro centro
+		void step(const rect& paddle1, const rect& paddle2);
+
+		std::span<const ball_body> balls() const noexcept { return pool; }
+		float radius() const noexcept { return r; }
+		std::size_t capacity() const noexcept { return pool.capacity(); }
+
+		const multiball_stats& stats() const noexcept { return st; }
+		pair<int> goals() const noexcept { return { goalCount[0], goalCount[1] }; }
+
+	private:
+		court_t court;
+		physics_profile profile;
+		bool solids; // paredes extras ou obstáculos além das duas bordas
+		rect area;
+		float r;
+		std::uint64_t key, tick = 0;
+
+		std::vector<ball_body> pool, sorted; // sorted: rascunho do build_grid
+
+		// grade: depois do build_grid as bolas da célula c são
+		// pool[cellStart[c] .. cellStart[c+1])
+		float invCell;
+		int cols, rows;
+		std::vector<std::uint32_t> cellStart, cellBalls, ballCell;
+
+		int goalCount[2] = {};
+		multiball_stats st;
+
+		ball_body launch(rng_stream& dice) const noexcept;
+		int cell_of(point p) const noexcept;
+
+		void build_grid();
+		void collide_balls();
+		void collide_paddle(ball_body& b, const rect& paddle) noexcept;
+	};
+}
@@ -0,0 +1,297 @@
+#include <algorithm>
+#include <charconv>
+#include "netplay.h"
+#include "gvar.h"
+#include "wire.h"
+
+using namespace std::literals;
+
+namespace
+{
+	constexpr std::uint32_t magic = 0x4e504653; // "SFPN"
+
+	enum input_bits : std::uint8_t { bit_up = 1, bit_down = 2, bit_fast = 4, bit_joystick = 8, bit_serve = 16 };
+
+	void put_input(util::wire_writer& w, const pong::player_input& in)
+	{
+		std::uint8_t bits = (in.up ? bit_up : 0) | (in.down ? bit_down : 0) | (in.fast ? bit_fast : 0)
+			| (in.joystick ? bit_joystick : 0) | (in.serve ? bit_serve : 0);
+		w.put(bits).put(in.axis);
+	}
+
+	pong::player_input get_input(util::wire_reader& r)
+	{
+		pong::player_input in;
+		const auto bits = r.get<std::uint8_t>();
+		in.axis = r.get<float>();
+		in.up = bits & bit_up;
+		in.down = bits & bit_down;
+		in.fast = bits & bit_fast;
+		in.joystick = bits & bit_joystick;
+		in.serve = bits & bit_serve;
+		return in;
+	}
+}
+
+pong::netplay::netplay(const netplay_config& cfg_)
+	: cfg(cfg_)
+{
+	const auto colon = cfg.peer.rfind(':');
+	if (colon == std::string::npos) {
+		spdlog::error("netplay: peer must be host:port, got '{}'", cfg.peer);
+		return;
+	}
+
+	const auto host = cfg.peer.substr(0, colon);
+	const auto port = std::string_view(cfg.peer).substr(colon + 1);
+	peerAddr = sf::IpAddress(host);
+	if (peerAddr == sf::IpAddress::None
+		|| std::from_chars(port.data(), port.data() + port.size(), peerPort).ec != std::errc()) {
+		spdlog::error("netplay: invalid peer '{}'", cfg.peer);
+		return;
+	}
+
+	if (socket.bind(cfg.localPort) != sf::Socket::Done) {
+		spdlog::error("netplay: failed to bind udp port {}", cfg.localPort);
+		return;
+	}
+	socket.setBlocking(false);
+	outbox.reserve(64);
+	bound = true;
+
+	spdlog::info("netplay: port {} -> {}:{} as player {}", cfg.localPort, host, peerPort, int(cfg.side) + 1);
+	if (cfg.link.latencyMs || cfg.link.jitterMs || cfg.link.loss > 0) {
+		spdlog::info("netplay: simulated link {} ms +-{} ms, {:.0f}% loss",
+			cfg.link.latencyMs, cfg.link.jitterMs, cfg.link.loss * 100);
+	}
+}
+
+std::uint32_t pong::netplay::now_ms() const
+{
+	// 0 = sem timestamp
+	return std::uint32_t((clock::now() - epoch) / 1ms) + 1;
+}
+
+pong::tick_input pong::netplay::inputs_for(std::uint32_t t) const
+{
+	const int me = int(cfg.side), them = 1 - me;
+
+	tick_input in;
+	in.players[me] = localInputs[t % history];
+
+	if (t < remoteConfirmed) {
+		in.players[them] = remoteInputs[t % history];
+	}
+	else if (remoteConfirmed > 0)
+	{
+		// previsão: o remoto continua fazendo o que fazia, menos sacar
+		in.players[them] = remoteInputs[(remoteConfirmed - 1) % history];
+		in.players[them].serve = false;
+	}
+
+	return in;
+}
+
+bool pong::netplay::update(match& sim, const player_input& local, bool paused)
+{
+	if (!bound)
+		return false;
+
+	receive();
+	resimulate(sim);
+
+	if (peerHashTick > checkedHashTick && peerHashTick <= remoteConfirmed
+		&& peerHashTick < localTick && peerHashTick + history > localTick)
+	{
+		checkedHashTick = peerHashTick;
+		if (hash(states[peerHashTick % history]) != peerHash && st.desyncs++ == 0) {
+			spdlog::error("netplay: desync at tick {}", peerHashTick);
+		}
+	}
+
+	bool used = false;
+	if (!paused && peerSeen)
+	{
+		// muito à frente do remoto: não dá mais pra voltar, espera.
+		// Um pouco à frente: segura um frame de vez em quando pros dois
+		// lados andarem juntos e os rollbacks ficarem curtos
+		const auto rttTicks = std::uint32_t(st.rttMs * gvar::tick_rate / 2000);
+		const bool tooFar = localTick >= remoteConfirmed + max_rollback;
+		const bool ahead = localTick > remoteTick + rttTicks + 1 && localTick % 8 == 0;
+
+		if (tooFar || ahead) {
+			st.stalls++;
+		}
+		else {
+			localInputs[localTick % history] = local;
+			simulate(sim, localTick);
+			localTick++;
+			used = true;
+		}
+	}
+
+	send();
+	flush_outbox();
+	return used;
+}
+
+void pong::netplay::simulate(match& sim, std::uint32_t t)
+{
+	const auto in = inputs_for(t);
+
+	sim.save(states[t % history]);
+	usedRemote[t % history] = in.players[1 - int(cfg.side)];
+
+	sim_message msg;
+	msg.in = in;
+	sim.apply(msg);
+	sim.step();
+}
+
+void pong::netplay::resimulate(match& sim)
+{
+	const auto from = std::exchange(rollbackFrom, UINT32_MAX);
+	if (from >= localTick)
+		return;
+
+	const auto start = clock::now();
+	const auto depth = localTick - from;
+
+	sim.restore(states[from % history]);
+	sim.mute(true);
+	for (auto t = from; t < localTick; t++) {
+		simulate(sim, t);
+	}
+	sim.mute(false);
+
+	const auto us = std::chrono::duration<double, std::micro>(clock::now() - start).count();
+	st.rollbacks++;
+	st.resimTicks += depth;
+	st.lastResimUs = us;
+	st.maxResimUs = std::max(st.maxResimUs, us);
+	st.maxDepth = std::max(st.maxDepth, int(depth));
+}
+
+void pong::netplay::receive()
+{
+	std::uint8_t buf[512];
+	std::size_t size = 0;
+	sf::IpAddress sender;
+	unsigned short port = 0;
+
+	while (socket.receive(buf, sizeof(buf), size, sender, port) == sf::Socket::Done)
+	{
+		if (sender != peerAddr)
+			continue;
+
+		st.received++;
+		read_packet(buf, size);
+	}
+}
+
+void pong::netplay::read_packet(const std::uint8_t* data, std::size_t size)
+{
+	util::wire_reader r(data, size);
+	if (r.get<std::uint32_t>() != magic)
+		return;
+
+	const auto senderTick = r.get<std::uint32_t>();
+	const auto ack = r.get<std::uint32_t>();
+	const auto sendTime = r.get<std::uint32_t>();
+	const auto echoTime = r.get<std::uint32_t>();
+	const auto hashTick = r.get<std::uint32_t>();
+	const auto stateHash = r.get<std::uint64_t>();
+	const auto start = r.get<std::uint32_t>();
+	const auto count = r.get<std::uint8_t>();
+	if (!r.ok())
+		return;
+
+	if (!peerSeen) {
+		peerSeen = true;
+		spdlog::info("netplay: peer connected");
+	}
+
+	remoteTick = std::max(remoteTick, senderTick);
+	remoteAcked = std::max(remoteAcked, ack);
+	peerTime = sendTime;
+
+	if (echoTime)
+	{
+		const auto rtt = float(now_ms() - echoTime);
+		st.rttMs = st.rttMs == 0 ? rtt : st.rttMs * 0.9f + rtt * 0.1f;
+	}
+
+	if (hashTick > peerHashTick) {
+		peerHashTick = hashTick;
+		peerHash = stateHash;
+	}
+
+	for (std::uint32_t t = start; t < start + count; t++)
+	{
+		const auto in = get_input(r);
+		if (!r.ok())
+			break;
+
+		// já temos, ou um buraco (pacote perdido): o remoto reenvia
+		// tudo a partir do nosso ack
+		if (t < remoteConfirmed)
+			continue;
+		if (t > remoteConfirmed)
+			break;
+
+		remoteInputs[t % history] = in;
+		if (t < localTick && usedRemote[t % history] != in) {
+			rollbackFrom = std::min(rollbackFrom, t);
+		}
+		remoteConfirmed++;
+	}
+}
+
+void pong::netplay::send()
+{
+	packet p;
+	util::wire_writer w(p.data.data(), p.data.size());
+
+	// último tick em que os dois lados já têm o estado definitivo
+	const auto hashTick = std::min(remoteConfirmed, localTick > 0 ? localTick - 1 : 0);
+	const auto stateHash = hashTick > 0 ? hash(states[hashTick % history]) : 0;
+
+	// tudo que o remoto ainda não confirmou, dentro do histórico
+	const auto oldest = localTick >= history ? localTick - history + 1 : 0;
+	const auto start = std::max(remoteAcked, oldest);
+	const auto count = std::uint8_t(localTick > start ? localTick - start : 0);
+
+	w.put(magic).put(localTick).put(remoteConfirmed).put(now_ms()).put(peerTime)
+		.put(hashTick).put(stateHash).put(start).put(count);
+	for (auto t = start; t < start + count; t++) {
+		put_input(w, localInputs[t % history]);
+	}
+	p.size = std::uint16_t(w.size());
+
+	auto& link = cfg.link;
+	if (link.loss > 0 && std::uniform_real_distribution<float>(0, 1)(linkRng) < link.loss) {
+		st.dropped++;
+		return;
+	}
+
+	auto delay = link.latencyMs;
+	if (link.jitterMs > 0) {
+		delay += std::uniform_int_distribution(-link.jitterMs, link.jitterMs)(linkRng);
+	}
+	p.release = clock::now() + std::max(delay, 0) * 1ms;
+	outbox.push_back(p);
+}
+
+void pong::netplay::flush_outbox()
+{
+	const auto now = clock::now();
+
+	std::erase_if(outbox, [&](const packet& p) {
+		if (p.release > now)
+			return false;
+
+		socket.send(p.data.data(), p.size, peerAddr, peerPort);
+		st.sent++;
+		return true;
+	});
+}
@@ -0,0 +1,113 @@
+#pragma once
+// partida de 2 jogadores P2P por UDP, com rollback: cada lado simula na hora
+// com o input local e uma previsão do remoto (repete o último confirmado).
+// Quando o input de verdade chega diferente do previsto, volta pro estado
+// salvo daquele tick e re-simula até o presente.
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <random>
+#include <string>
+#include <vector>
+#include "SFML/Network/UdpSocket.hpp"
+#include "SFML/Network/IpAddress.hpp"
+#include "match.h"
+
+namespace pong
+{
+	// simula uma rede ruim nos pacotes enviados, pra testar em localhost
+	struct link_conditions
+	{
+		int latencyMs = 0, jitterMs = 0;
+		float loss = 0; // 0..1
+	};
+
+	struct netplay_config
+	{
+		unsigned short localPort = 0;
+		std::string peer; // "host:porta"
+		playerid side = playerid::one;
+		link_conditions link;
+	};
+
+	struct netplay_stats
+	{
+		std::uint64_t rollbacks = 0, resimTicks = 0;
+		double lastResimUs = 0, maxResimUs = 0;
+		int maxDepth = 0; // maior rollback, em ticks
+		float rttMs = 0;
+		std::uint64_t stalls = 0; // frames esperando o remoto
+		std::uint64_t desyncs = 0;
+		std::uint64_t sent = 0, received = 0, dropped = 0;
+	};
+
+	class netplay
+	{
+	public:
+		static constexpr int max_rollback = 12; // 200 ms a 60 Hz
+
+		explicit netplay(const netplay_config& cfg);
+
+		bool ok() const noexcept { return bound; }
+		bool connected() const noexcept { return peerSeen; }
+
+		// uma vez por frame: recebe, corrige o passado se preciso,
+		// avança um tick (se não estiver pausado nem muito à frente) e envia.
+		// false: não simulou, local foi descartado (o saque tem que esperar)
+		bool update(match& sim, const player_input& local, bool paused);
+
+		const netplay_stats& stats() const noexcept { return st; }
+		std::uint32_t tick() const noexcept { return localTick; }
+		// ticks simulados com input remoto ainda não confirmado
+		int predicted() const noexcept { return localTick > remoteConfirmed ? int(localTick - remoteConfirmed) : 0; }
+
+	private:
+		using clock = std::chrono::steady_clock;
+		static constexpr std::uint32_t history = 64; // potência de 2, > max_rollback
+
+		struct packet
+		{
+			clock::time_point release;
+			std::uint16_t size;
+			std::array<std::uint8_t, 512> data;
+		};
+
+		netplay_config cfg;
+		sf::UdpSocket socket;
+		sf::IpAddress peerAddr;
+		unsigned short peerPort = 0;
+		bool bound = false, peerSeen = false;
+		clock::time_point epoch = clock::now();
+
+		// por tick, indexados por tick % history
+		std::array<game_state, history> states; // antes de simular o tick
+		std::array<player_input, history> localInputs, remoteInputs, usedRemote;
+
+		std::uint32_t localTick = 0;       // próximo tick a simular
+		std::uint32_t remoteConfirmed = 0; // inputs remotos < isso já chegaram
+		std::uint32_t remoteAcked = 0;     // o remoto já tem nossos inputs < isso
+		std::uint32_t remoteTick = 0;      // tick do remoto no último pacote
+		std::uint32_t rollbackFrom = UINT32_MAX;
+		std::uint32_t peerTime = 0;        // timestamp do remoto pra ecoar
+
+		// hash do estado definitivo do remoto, pra detectar desync
+		std::uint32_t peerHashTick = 0, checkedHashTick = 0;
+		std::uint64_t peerHash = 0;
+
+		// pacotes segurados pela link_conditions
+		std::vector<packet> outbox;
+		std::minstd_rand linkRng{ 42 };
+
+		netplay_stats st;
+
+		std::uint32_t now_ms() const;
+		tick_input inputs_for(std::uint32_t t) const;
+
+		void receive();
+		void read_packet(const std::uint8_t* data, std::size_t size);
+		void resimulate(match& sim);
+		void simulate(match& sim, std::uint32_t t);
+		void send();
+		void flush_outbox();
+	};
+}
@@ -0,0 +1,117 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include "SFML/Graphics/RenderTarget.hpp"
+#include "particles.h"
+
+namespace
+{
+	constexpr float drag = 0.985f; // por 1/60 s
+	constexpr float gravity = 180;  // px/s²
+	constexpr float streak = 0.03f; // comprimento do traço: s de movimento
+}
+
+pong::particle_system::particle_system(std::size_t capacity)
+	: x(capacity), y(capacity), vx(capacity), vy(capacity), life(capacity), invMaxLife(capacity)
+	, color(capacity), verts(capacity * 2), dice(squares::key(0x5041), 0)
+{
+}
+
+void pong::particle_system::emit(const particle_burst& b, int count)
+{
+	const auto room = capacity() - live;
+	if (std::size_t(count) > room)
+	{
+		droppedCount += count - room;
+		count = int(room);
+	}
+
+	const float base = b.dir == vec2() ? 0.f : std::atan2(b.dir.y, b.dir.x);
+
+	for (int n = 0; n < count; n++)
+	{
+		const auto i = live++;
+		const float angle = base + (dice.unit() * 2 - 1) * b.spread;
+		const float speed = b.speedMin + (b.speedMax - b.speedMin) * dice.unit();
+		const float ttl = b.lifeMin + (b.lifeMax - b.lifeMin) * dice.unit();
+
+		x[i] = b.pos.x;
+		y[i] = b.pos.y;
+		vx[i] = std::cos(angle) * speed;
+		vy[i] = std::sin(angle) * speed;
+		life[i] = ttl;
+		invMaxLife[i] = 1 / ttl;
+		color[i] = b.color;
+	}
+}
+
+void pong::particle_system::update(float dt)
+{
+	const auto start = std::chrono::steady_clock::now();
+	const std::size_t n = live;
+	const float damp = std::pow(drag, dt * 60);
+	const float fall = gravity * dt;
+
+	// campo por campo, sem desvio: vetoriza
+	float* __restrict px = x.data();
+	float* __restrict py = y.data();
+	float* __restrict pvx = vx.data();
+	float* __restrict pvy = vy.data();
+	float* __restrict pl = life.data();
+
+	for (std::size_t i = 0; i < n; i++) {
+		pvx[i] *= damp;
+		pvy[i] = pvy[i] * damp + fall;
+		px[i] += pvx[i] * dt;
+		py[i] += pvy[i] * dt;
+		pl[i] -= dt;
+	}
+
+	kill_dead();
+	build_vertices();
+	lastUpdateUs = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+}
+
+void pong::particle_system::kill_dead()
+{
+	// troca a morta pela última viva; a ordem não importa
+	for (std::size_t i = 0; i < live;)
+	{
+		if (life[i] > 0) {
+			i++;
+			continue;
+		}
+
+		const auto last = --live;
+		x[i] = x[last];
+		y[i] = y[last];
+		vx[i] = vx[last];
+		vy[i] = vy[last];
+		life[i] = life[last];
+		invMaxLife[i] = invMaxLife[last];
+		color[i] = color[last];
+	}
+}
+
+void pong::particle_system::build_vertices()
+{
+	for (std::size_t i = 0; i < live; i++)
+	{
+		auto c = color[i];
+		c.a = sf::Uint8(c.a * std::min(life[i] * invMaxLife[i], 1.f));
+
+		auto* v = &verts[i * 2];
+		v[0].position = { x[i], y[i] };
+		v[0].color = c;
+		v[1].position = { x[i] - vx[i] * streak, y[i] - vy[i] * streak };
+		c.a /= 4;
+		v[1].color = c;
+	}
+}
+
+void pong::particle_system::draw(sf::RenderTarget& target, sf::RenderStates states) const
+{
+	if (live > 0) {
+		target.draw(verts.data(), live * 2, sf::Lines, states);
+	}
+}
@@ -0,0 +1,53 @@
+#pragma once
+// partículas só de enfeite (faíscas, rastro, gol): não entram na simulação.
+// Pool de capacidade fixa em SoA, um array por campo: o update é um loop
+// reto por array que o compilador vetoriza. Tudo alocado no construtor
+#include <cstdint>
+#include <vector>
+#include "SFML/Graphics/Drawable.hpp"
+#include "SFML/Graphics/Vertex.hpp"
+#include "common.h"
+#include "rng.h"
+
+namespace pong
+{
+	struct particle_burst
+	{
+		point pos;
+		vec2 dir;            // direção média; zero = em todas as direções
+		float spread = 3.14159265f; // meia abertura do cone, rad
+		float speedMin = 60, speedMax = 240; // px/s
+		float lifeMin = 0.3f, lifeMax = 0.6f; // s
+		sf::Color color = sf::Color::White;
+	};
+
+	class particle_system : public sf::Drawable
+	{
+	public:
+		explicit particle_system(std::size_t capacity);
+
+		// o que não couber é descartado
+		void emit(const particle_burst& b, int count);
+		void update(float dt);
+		void clear() noexcept { live = 0; }
+
+		std::size_t size() const noexcept { return live; }
+		std::size_t capacity() const noexcept { return x.size(); }
+		std::uint64_t dropped() const noexcept { return droppedCount; }
+		double updateUs() const noexcept { return lastUpdateUs; }
+
+	private:
+		std::vector<float> x, y, vx, vy, life, invMaxLife;
+		std::vector<sf::Color> color;
+		std::size_t live = 0;
+
+		std::vector<sf::Vertex> verts; // 2 por partícula (sf::Lines)
+		rng_stream dice;
+		std::uint64_t droppedCount = 0;
+		double lastUpdateUs = 0;
+
+		void kill_dead();
+		void build_vertices();
+		void draw(sf::RenderTarget& target, sf::RenderStates states) const override;
+	};
+}
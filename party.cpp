@@ -0,0 +1,343 @@
+#include <algorithm>
+#include <cmath>
+#include "party.h"
+#include "gvar.h"
+
+namespace
+{
+	using pong::side;
+	using pong::vec2;
+
+	constexpr float margin = 10;       // raquete até a linha do gol, como em match
+	constexpr float corner = 60;       // raquetes de cima/baixo não entram nos cantos
+	constexpr float pi = 3.14159265f;
+
+	bool vertical(side s) noexcept { return s == side::left || s == side::right; }
+
+	// pra dentro da quadra
+	vec2 normal_of(side s) noexcept
+	{
+		switch (s)
+		{
+		case side::left: return { 1, 0 };
+		case side::right: return { -1, 0 };
+		case side::top: return { 0, 1 };
+		default: return { 0, -1 };
+		}
+	}
+
+	float& along(vec2& v, side s) noexcept { return vertical(s) ? v.y : v.x; }
+	float along(const vec2& v, side s) noexcept { return vertical(s) ? v.y : v.x; }
+
+	const sf::Color paddle_colors[] = {
+		sf::Color::White, sf::Color::White, { 120, 200, 255 }, { 255, 200, 120 }
+	};
+}
+
+pong::party_match::party_match(const court_t& court_, int players_, int balls, std::uint64_t seed, const physics_profile& guts)
+	: court(court_)
+	, profile(guts)
+	, players(std::clamp(players_, 2, max_players))
+	, ballCount(std::max(balls, 1))
+	, key(squares::key(seed))
+{
+	pads.reserve(max_players);
+	ballTable.reserve(std::size_t(ballCount));
+	reset();
+}
+
+float pong::party_match::lineOf(side s) const noexcept
+{
+	switch (s)
+	{
+	case side::left: return 0;
+	case side::right: return court.size.x;
+	case side::top: return court.topInner();
+	default: return court.bottomInner();
+	}
+}
+
+void pong::party_match::launch(point& pos, vec2& vel, rng_stream& dice) const noexcept
+{
+	// pra um dos jogadores, com um pouco de ângulo
+	constexpr float towards[] = { pi, 0, -pi / 2, pi / 2 };
+	const float angle = towards[dice.range(0, players - 1)] + (dice.unit() - 0.5f);
+
+	pos = { court.size.x / 2, (court.topInner() + court.bottomInner()) / 2 };
+	vel = { std::cos(angle) * profile.ball_speed, std::sin(angle) * profile.ball_speed };
+}
+
+void pong::party_match::set_humans(int humans) noexcept
+{
+	auto ctl = pads.get<comp::controller>();
+	for (std::size_t i = 0; i < ctl.size(); i++)
+	{
+		ctl[i].kind = int(i) < humans ? comp::controller::human : comp::controller::ai;
+		ctl[i].input = std::uint8_t(i);
+	}
+}
+
+void pong::party_match::reset()
+{
+	const float paddle_width = profile.paddle_width, paddle_height = profile.paddle_height;
+	const float ball_radius = profile.ball_radius;
+
+	// mantém quem é humano
+	int humans = 0;
+	for (auto& c : pads.get<comp::controller>()) {
+		humans += c.kind == comp::controller::human;
+	}
+
+	pads.clear();
+	ballTable.clear();
+	std::fill(std::begin(goals), std::end(goals), 0);
+	std::fill(std::begin(owned), std::end(owned), false);
+
+	const point center = { court.size.x / 2, (court.topInner() + court.bottomInner()) / 2 };
+	const float inset = margin + paddle_width * 1.5f;
+
+	for (int i = 0; i < players; i++)
+	{
+		const auto s = side(i);
+		owned[i] = true;
+
+		// caixa com o contorno, igual a player_t
+		vec2 half = { paddle_width / 2 + gvar::paddle_outline, paddle_height / 2 + gvar::paddle_outline };
+		point pos = center;
+
+		if (vertical(s)) {
+			pos.x = s == side::left ? inset : court.size.x - inset;
+		}
+		else {
+			std::swap(half.x, half.y);
+			pos.y = lineOf(s) + normal_of(s).y * (margin + paddle_width / 2);
+		}
+
+		pads.add({ pos }, {}, { half }, { comp::controller::ai, std::uint8_t(i), s }, { paddle_colors[i] });
+	}
+	set_humans(humans);
+
+	auto dice = rng_stream(key, tick);
+	for (int i = 0; i < ballCount; i++)
+	{
+		comp::position pos;
+		comp::velocity vel;
+		launch(pos.value, vel.value, dice);
+		ballTable.add(pos, vel, { { ball_radius, ball_radius } }, { sf::Color::Red });
+	}
+	tick++;
+}
+
+void pong::party_match::step(std::span<const player_input> inputs)
+{
+	auto dice = rng_stream(key, tick);
+
+	control(inputs);
+	move();
+	collide();
+	score(dice);
+	tick++;
+}
+
+void pong::party_match::control(std::span<const player_input> inputs)
+{
+	const float paddle_max_speed = profile.paddle_max_speed;
+
+	const auto ctl = pads.get<comp::controller>();
+	const auto pos = pads.get<comp::position>();
+	const auto vel = pads.get<comp::velocity>();
+	const auto ballPos = ballTable.get<comp::position>();
+	const auto ballVel = ballTable.get<comp::velocity>();
+
+	for (std::size_t i = 0; i < ctl.size(); i++)
+	{
+		auto& c = ctl[i];
+		const auto n = normal_of(c.side);
+		const float before = along(vel[i].value, c.side);
+		float mom = before;
+		bool turbo = false;
+
+		if (c.kind == comp::controller::ai)
+		{
+			// mesmo ritmo da IA de match: reage a cada 0.1s
+			if (--c.aiWait <= 0)
+			{
+				c.aiWait = gvar::tick_rate / 10;
+
+				// a bola mais perto que vem na minha direção
+				float target = along(pos[i].value, c.side), best = INFINITY;
+				for (std::size_t b = 0; b < ballPos.size(); b++)
+				{
+					const auto d = ballPos[b].value - pos[i].value;
+					const float dist = std::abs(n.x * d.x + n.y * d.y);
+					const bool coming = n.x * ballVel[b].value.x + n.y * ballVel[b].value.y < 0;
+					if (coming && dist < best) {
+						best = dist;
+						target = along(ballPos[b].value, c.side);
+					}
+				}
+
+				const float diff = target - along(pos[i].value, c.side);
+				if (std::abs(diff) >= profile.ball_radius) {
+					mom += std::copysign(1.f, diff);
+					turbo = std::abs(diff) > 99;
+				}
+			}
+		}
+		else if (c.input < inputs.size())
+		{
+			// em cima/baixo: up vai pra esquerda
+			auto& in = inputs[c.input];
+			if (in.up)
+				mom -= profile.paddle_kb_speed;
+			else if (in.down)
+				mom += profile.paddle_kb_speed;
+
+			if (in.joystick)
+				mom = in.axis / 3;
+
+			turbo = in.fast;
+		}
+
+		mom = std::clamp(mom, -paddle_max_speed, paddle_max_speed);
+		if (turbo) {
+			mom *= 1.25f;
+		}
+		else if (c.kind == comp::controller::human && mom == before) {
+			mom *= 0.6f;
+		}
+
+		vel[i].value = {};
+		along(vel[i].value, c.side) = mom;
+	}
+}
+
+void pong::party_match::move()
+{
+	// bolas: loop reto nas duas colunas
+	const auto ballPos = ballTable.get<comp::position>();
+	const auto ballVel = ballTable.get<comp::velocity>();
+	for (std::size_t i = 0; i < ballPos.size(); i++) {
+		ballPos[i].value += ballVel[i].value;
+	}
+
+	const auto pos = pads.get<comp::position>();
+	const auto vel = pads.get<comp::velocity>();
+	const auto half = pads.get<comp::collider>();
+	const auto ctl = pads.get<comp::controller>();
+
+	for (std::size_t i = 0; i < pos.size(); i++)
+	{
+		const auto s = ctl[i].side;
+		pos[i].value += vel[i].value;
+
+		// bateu na borda/canto: para, como em match
+		const float h = along(half[i].half, s);
+		const float lo = vertical(s) ? court.topInner() + h + 2 : court.top.left + h + corner;
+		const float hi = vertical(s) ? court.bottomInner() - h - 2 : court.top.left + court.top.width - h - corner;
+		auto& p = along(pos[i].value, s);
+		if (p < lo || p > hi) {
+			p = std::clamp(p, lo, hi);
+			vel[i].value = {};
+		}
+	}
+}
+
+void pong::party_match::collide()
+{
+	const auto ballPos = ballTable.get<comp::position>();
+	const auto ballVel = ballTable.get<comp::velocity>();
+	const auto ballHalf = ballTable.get<comp::collider>();
+
+	const auto padPos = pads.get<comp::position>();
+	const auto padVel = pads.get<comp::velocity>();
+	const auto padHalf = pads.get<comp::collider>();
+	const auto ctl = pads.get<comp::controller>();
+
+	const float top = court.topInner(), bottom = court.bottomInner();
+
+	for (std::size_t b = 0; b < ballPos.size(); b++)
+	{
+		auto& p = ballPos[b].value;
+		auto& v = ballVel[b].value;
+		const auto r = ballHalf[b].half;
+
+		// lado sem jogador é parede
+		if (!owned[int(side::top)] && p.y - r.y < top) {
+			p.y = top + r.y;
+			v.y = std::abs(v.y);
+		}
+		if (!owned[int(side::bottom)] && p.y + r.y > bottom) {
+			p.y = bottom - r.y;
+			v.y = -std::abs(v.y);
+		}
+
+		// paredes extras e obstáculos da arena. As bordas ficam com o teste
+		// de cima: com jogador naquele lado elas são linha de gol
+		court.map->solids.query({ p - r, r * 2.f }, [&](const rect& wall) {
+			if (wall != court.map->top && wall != court.map->bottom) {
+				bounce(p, r, v, wall);
+			}
+		});
+
+		// poucas raquetes: testa todas
+		for (std::size_t i = 0; i < padPos.size(); i++)
+		{
+			const auto d = p - padPos[i].value;
+			const auto reach = r + padHalf[i].half;
+			if (std::abs(d.x) >= reach.x || std::abs(d.y) >= reach.y)
+				continue;
+
+			const auto s = ctl[i].side;
+			const auto n = normal_of(s);
+			const float vn = v.x * n.x + v.y * n.y;
+			if (vn >= 0)
+				continue; // já está saindo
+
+			// volta pela normal mais rápida, ganha metade do movimento da raquete
+			const float ball_max_speed = profile.ball_max_speed;
+			const float speed = std::min(-vn + profile.ball_acceleration, ball_max_speed);
+			const float tangent = std::clamp(along(v, s) + along(padVel[i].value, s) * 0.5f, -ball_max_speed, ball_max_speed);
+
+			v = n * speed;
+			along(v, s) = tangent;
+
+			// encosta do lado de fora da raquete
+			if (vertical(s))
+				p.x = padPos[i].value.x + n.x * reach.x;
+			else
+				p.y = padPos[i].value.y + n.y * reach.y;
+		}
+	}
+}
+
+void pong::party_match::score(rng_stream& dice)
+{
+	const auto ballPos = ballTable.get<comp::position>();
+	const auto ballVel = ballTable.get<comp::velocity>();
+	const auto ballHalf = ballTable.get<comp::collider>();
+
+	for (std::size_t b = 0; b < ballPos.size(); b++)
+	{
+		auto& p = ballPos[b].value;
+		const float r = ballHalf[b].half.x;
+
+		// esquerda/direita: saiu toda, como em match. Cima/baixo: o centro
+		// passou da borda
+		int loser = -1;
+		if (p.x < -r)
+			loser = int(side::left);
+		else if (p.x > court.size.x + r)
+			loser = int(side::right);
+		else if (owned[int(side::top)] && p.y < lineOf(side::top))
+			loser = int(side::top);
+		else if (owned[int(side::bottom)] && p.y > lineOf(side::bottom))
+			loser = int(side::bottom);
+
+		if (loser >= 0)
+		{
+			goals[loser]++;
+			launch(p, ballVel[b].value, dice);
+		}
+	}
+}
@@ -0,0 +1,80 @@
+#pragma once
+// modo festa: 2 a 4 raquetes (esquerda, direita, cima, baixo) e quantas bolas
+// quiser. Raquetes e bolas vivem em component_table: cada sistema (controle,
+// movimento, colisão, gols) é um loop sobre as colunas que usa, então o custo
+// cresce linear com o número de bolas. A partida normal continua em match
+#include <cstdint>
+#include <span>
+#include <vector>
+#include "SFML/Graphics/Color.hpp"
+#include "common.h"
+#include "component_table.h"
+#include "match.h"
+#include "rng.h"
+
+namespace pong
+{
+	// lados da quadra, na ordem em que os jogadores entram
+	enum struct side : std::uint8_t { left, right, top, bottom };
+
+	namespace comp
+	{
+		struct position { point value; };
+		struct velocity { vec2 value; };
+		struct collider { vec2 half; }; // caixa centrada em position
+
+		struct controller
+		{
+			enum kind_t : std::uint8_t { human, ai } kind = ai;
+			std::uint8_t input = 0; // humano: índice em step(inputs)
+			pong::side side = side::left;
+			std::int32_t aiWait = 0;
+		};
+
+		struct sprite { sf::Color color = sf::Color::White; };
+	}
+
+	using paddle_table = util::component_table<comp::position, comp::velocity, comp::collider, comp::controller, comp::sprite>;
+	using ball_table = util::component_table<comp::position, comp::velocity, comp::collider, comp::sprite>;
+
+	class party_match
+	{
+	public:
+		static constexpr int max_players = 4;
+
+		// guts: a física da partida (velocidades, tamanhos)
+		party_match(const court_t& court, int players, int balls, std::uint64_t seed = 1337, const physics_profile& guts = {});
+
+		// humans: quantos jogadores, a partir do primeiro, usam inputs[i]
+		void set_humans(int humans) noexcept;
+		void reset();
+		void step(std::span<const player_input> inputs);
+
+		const paddle_table& paddles() const noexcept { return pads; }
+		const ball_table& balls() const noexcept { return ballTable; }
+
+		// gols sofridos por jogador
+		std::span<const int> conceded() const noexcept { return { goals, std::size_t(players) }; }
+		int players_count() const noexcept { return players; }
+		std::uint64_t ticks() const noexcept { return tick; }
+
+	private:
+		court_t court;
+		physics_profile profile;
+		int players, ballCount;
+		std::uint64_t key, tick = 0;
+		int goals[max_players] = {};
+		bool owned[4] = {}; // lado tem raquete (gol) ou é parede
+
+		paddle_table pads;
+		ball_table ballTable;
+
+		float lineOf(side s) const noexcept;
+		void launch(point& pos, vec2& vel, rng_stream& dice) const noexcept;
+
+		void control(std::span<const player_input> inputs);
+		void move();
+		void collide();
+		void score(rng_stream& dice);
+	};
+}
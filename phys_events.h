@@ -0,0 +1,49 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include "common.h"
+
+namespace pong
+{
+	// evento gerado pela física durante um tick,
+	// consumido (placar, telemetria, render...) depois dele
+	struct phys_event
+	{
+		enum kind_t : std::uint8_t { paddle_hit, wall_bounce, goal } kind;
+		playerid player; // paddle_hit: quem rebateu; goal: quem pontuou
+		float time;      // fração do tick em que aconteceu, [0, 1]
+		point pos;       // posição da bola
+		vec2 vel;        // velocidade da bola depois do evento
+		float offset;    // paddle_hit: ponto do impacto, -1 = ponta de cima, 1 = de baixo
+	};
+
+	// fila de capacidade fixa, limpa a cada tick
+	template<std::size_t N>
+	class event_queue
+	{
+	public:
+		void push(const phys_event& ev) noexcept
+		{
+			if (count < N)
+				items[count++] = ev;
+			else
+				overflow++;
+		}
+
+		void clear() noexcept { count = 0; }
+
+		std::size_t size() const noexcept { return count; }
+		bool empty() const noexcept { return count == 0; }
+		// eventos perdidos com a fila cheia
+		std::uint64_t overflowed() const noexcept { return overflow; }
+
+		const phys_event* begin() const noexcept { return items.data(); }
+		const phys_event* end() const noexcept { return items.data() + count; }
+
+	private:
+		std::array<phys_event, N> items;
+		std::size_t count = 0;
+		std::uint64_t overflow = 0;
+	};
+}
@@ -0,0 +1,41 @@
+#pragma once
+#include <array>
+#include <cstddef>
+
+namespace util
+{
+    // buffer circular de tamanho fixo, sobrescreve os mais antigos.
+    // os dados ficam contíguos pra ImGui::PlotLines (ver offset())
+    template<class T, std::size_t N>
+    class ring_buffer
+    {
+        static_assert(N > 0);
+
+    public:
+        void push(const T& value) noexcept
+        {
+            items[head] = value;
+            head = (head + 1) % N;
+            if (count < N) count++;
+        }
+
+        void clear() noexcept { head = count = 0; }
+
+        std::size_t size() const noexcept { return count; }
+        static constexpr std::size_t capacity() noexcept { return N; }
+        bool empty() const noexcept { return count == 0; }
+        bool full() const noexcept { return count == N; }
+
+        // i = 0 é o mais antigo
+        const T& operator[](std::size_t i) const noexcept { return items[(offset() + i) % N]; }
+        const T& back() const noexcept { return items[(head + N - 1) % N]; }
+
+        // índice do mais antigo em data()
+        std::size_t offset() const noexcept { return full() ? head : 0; }
+        const T* data() const noexcept { return items.data(); }
+
+    private:
+        std::array<T, N> items{};
+        std::size_t head = 0, count = 0;
+    };
+}
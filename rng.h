@@ -1,8 +1,76 @@
 #pragma once
+#include <cstddef>
+#include <cstdint>
 
 namespace pong {
 	int random_num(int min, int max);
 	bool coin_flip();
+
+	// Squares (Widynski, 2020): RNG baseado em contador. O número é uma função
+	// pura de (contador, chave), sem estado compartilhado entre threads.
+	// A chave identifica a partida e o contador é o tick + o sorteio dentro
+	// do tick, então o resultado não depende da ordem nem da thread
+	namespace squares
+	{
+		constexpr std::uint32_t draw(std::uint64_t ctr, std::uint64_t key) noexcept
+		{
+			std::uint64_t x = ctr * key, y = x, z = y + key;
+			x = x * x + y; x = (x >> 32) | (x << 32);
+			x = x * x + z; x = (x >> 32) | (x << 32);
+			x = x * x + y; x = (x >> 32) | (x << 32);
+			return std::uint32_t((x * x + z) >> 32);
+		}
+
+		// o algoritmo quer chaves "embaralhadas" e ímpares; splitmix64 do id
+		constexpr std::uint64_t key(std::uint64_t id) noexcept
+		{
+			std::uint64_t z = id + 0x9E3779B97F4A7C15ull;
+			z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+			z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+			return (z ^ (z >> 31)) | 1;
+		}
+
+		// n sorteios seguidos a partir de ctr. Nenhuma iteração depende da
+		// anterior, o compilador vetoriza o loop
+		inline void fill(std::uint64_t key, std::uint64_t ctr, std::uint32_t* out, std::size_t n) noexcept
+		{
+			for (std::size_t i = 0; i < n; i++)
+				out[i] = draw(ctr + i, key);
+		}
+	}
+
+	// sorteios de uma partida num tick. Cópia barata, cada um com o seu
+	class rng_stream
+	{
+	public:
+		static constexpr int draw_bits = 16; // sorteios por tick: 65536
+
+		constexpr rng_stream(std::uint64_t key, std::uint64_t tick) noexcept
+			: key(key), ctr(tick << draw_bits) {}
+
+		constexpr std::uint32_t next() noexcept { return squares::draw(ctr++, key); }
+
+		// [min, max]; multiplicação em vez de %, viés < 2^-32 * (max - min)
+		constexpr int range(int min, int max) noexcept
+		{
+			const auto span = std::uint64_t(std::int64_t(max) - min + 1);
+			return int(min + std::int64_t((next() * span) >> 32));
+		}
+
+		constexpr bool coin() noexcept { return next() >> 31; }
+
+		// [0, 1)
+		constexpr float unit() noexcept { return (next() >> 8) * (1.f / (1 << 24)); }
+
+		void fill(std::uint32_t* out, std::size_t n) noexcept
+		{
+			squares::fill(key, ctr, out, n);
+			ctr += n;
+		}
+
+	private:
+		std::uint64_t key, ctr;
+	};
 }
 
 namespace dice {
@@ -0,0 +1,104 @@
+#include <chrono>
+#include "sim_thread.h"
+#include "common.h"
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#elif defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+using namespace std::literals;
+
+namespace
+{
+	bool pin_current_thread(int cpu)
+	{
+#if defined(_WIN32)
+		return SetThreadAffinityMask(GetCurrentThread(), DWORD_PTR(1) << cpu) != 0;
+#elif defined(__linux__)
+		cpu_set_t set;
+		CPU_ZERO(&set);
+		CPU_SET(cpu, &set);
+		return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#else
+		(void)cpu;
+		return false;
+#endif
+	}
+}
+
+pong::sim_thread::sim_thread(match& sim_, int tickRate_, int cpu_)
+	: sim(sim_), tickRate(tickRate_), cpu(cpu_)
+{
+	frames.write() = sim.frame();
+	frames.publish();
+
+	worker = std::jthread([this](std::stop_token stop) { run(stop); });
+}
+
+pong::sim_thread::~sim_thread()
+{
+	worker.request_stop();
+	if (worker.joinable()) {
+		worker.join();
+	}
+	spdlog::debug("sim thread: {} ticks, {} dropped", sim.ticks(), dropped());
+}
+
+bool pong::sim_thread::send(const sim_message& msg) noexcept
+{
+	return inbox.push(msg);
+}
+
+void pong::sim_thread::run(std::stop_token stop)
+{
+	using clock = std::chrono::steady_clock;
+
+	if (cpu >= 0 && !pin_current_thread(cpu)) {
+		spdlog::warn("sim thread: failed to pin to cpu {}", cpu);
+	}
+
+	const auto period = std::chrono::duration_cast<clock::duration>(1s) / tickRate;
+	auto next = clock::now() + period;
+
+	while (!stop.stop_requested())
+	{
+		// o sleep do SO é grosso demais pra um tick de 16 ms, o último
+		// pedaço é no yield
+		std::this_thread::sleep_until(next - 2ms);
+		while (clock::now() < next) {
+			std::this_thread::yield();
+		}
+
+		int steps = 0;
+		for (auto now = clock::now(); now >= next && steps < max_catchup; steps++)
+		{
+			sim_message msg;
+			while (inbox.pop(msg)) {
+				sim.apply(msg);
+			}
+
+			if (!sim.paused()) {
+				sim.step();
+			}
+			next += period;
+		}
+		telemetry::tick(); // também pausado: o que veio antes da pausa não fica preso
+
+		// muito atrasado (debugger, suspensão...): recomeça do agora
+		// em vez de rodar uma rajada de ticks
+		if (const auto now = clock::now(); now >= next + period)
+		{
+			const auto behind = std::uint64_t((now - next) / period);
+			droppedTicks.fetch_add(behind, std::memory_order_relaxed);
+			next = now + period;
+		}
+
+		frames.write() = sim.frame();
+		frames.publish();
+	}
+}
@@ -0,0 +1,47 @@
+#pragma once
+#include <cstdint>
+#include <thread>
+#include "match.h"
+#include "spsc_queue.h"
+#include "triple_buffer.h"
+
+namespace pong
+{
+	// roda a partida em tick fixo numa thread só dela. A main thread manda
+	// input/comandos pela fila e lê o último estado publicado; nenhum dos
+	// dois lados espera pelo outro
+	class sim_thread
+	{
+	public:
+		// cpu < 0 = sem afinidade
+		sim_thread(match& sim, int tickRate, int cpu = -1);
+		~sim_thread();
+
+		sim_thread(const sim_thread&) = delete;
+
+		// só a main thread. false se a fila estiver cheia
+		bool send(const sim_message& msg) noexcept;
+
+		// true se chegou um frame novo desde a última chamada
+		bool update() noexcept { return frames.update(); }
+		const match_frame& latest() const noexcept { return frames.read(); }
+
+		// ticks descartados por atraso (> max_catchup)
+		std::uint64_t dropped() const noexcept { return droppedTicks.load(std::memory_order_relaxed); }
+
+	private:
+		static constexpr int max_catchup = 5;
+
+		match& sim;
+		const int tickRate;
+		const int cpu;
+
+		util::spsc_queue<sim_message, 256> inbox;
+		util::triple_buffer<match_frame> frames;
+		std::atomic<std::uint64_t> droppedTicks{ 0 };
+
+		std::jthread worker; // por último: para e junta antes do resto
+
+		void run(std::stop_token stop);
+	};
+}
@@ -0,0 +1,61 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <cstddef>
+
+namespace util
+{
+    // fila limitada de um produtor e um consumidor, sem locks.
+    // N precisa ser potência de 2; push() falha quando está cheia
+    template<class T, std::size_t N>
+    class spsc_queue
+    {
+        static_assert(N >= 2 && (N & (N - 1)) == 0, "N precisa ser potência de 2");
+
+    public:
+        spsc_queue() = default;
+        spsc_queue(const spsc_queue&) = delete;
+
+        // só o produtor
+        bool push(const T& value) noexcept
+        {
+            const auto t = tail.load(std::memory_order_relaxed);
+            if (t - headCache == N)
+            {
+                headCache = head.load(std::memory_order_acquire);
+                if (t - headCache == N)
+                    return false; // cheia
+            }
+
+            items[t & (N - 1)] = value;
+            tail.store(t + 1, std::memory_order_release);
+            return true;
+        }
+
+        // só o consumidor
+        bool pop(T& value) noexcept
+        {
+            const auto h = head.load(std::memory_order_relaxed);
+            if (h == tailCache)
+            {
+                tailCache = tail.load(std::memory_order_acquire);
+                if (h == tailCache)
+                    return false; // vazia
+            }
+
+            value = items[h & (N - 1)];
+            head.store(h + 1, std::memory_order_release);
+            return true;
+        }
+
+        static constexpr std::size_t capacity() noexcept { return N; }
+
+    private:
+        std::array<T, N> items{};
+        // índices crescem sem parar, a máscara acha o slot
+        alignas(64) std::atomic<std::size_t> head{ 0 };
+        std::size_t tailCache = 0; // cópia do consumidor
+        alignas(64) std::atomic<std::size_t> tail{ 0 };
+        std::size_t headCache = 0; // cópia do produtor
+    };
+}
@@ -0,0 +1,96 @@
+#include "startup.h"
+#include <mutex>
+#include <thread>
+#include <cstring>
+#include <fmt/format.h>
+
+namespace
+{
+	const auto t_start = pong::startup::clock::now();
+	const auto main_thread = std::this_thread::get_id();
+
+	std::mutex phases_mtx;
+	std::vector<pong::startup::phase> phases_;
+}
+
+auto pong::startup::process_start() noexcept -> clock::time_point
+{
+	return t_start;
+}
+
+double pong::startup::elapsed_ms() noexcept
+{
+	return elapsed_ms(t_start);
+}
+
+double pong::startup::elapsed_ms(clock::time_point since) noexcept
+{
+	using ms = std::chrono::duration<double, std::milli>;
+	return ms(clock::now() - since).count();
+}
+
+void pong::startup::record(const char* name, clock::time_point begin, clock::time_point end)
+{
+	using ms = std::chrono::duration<double, std::milli>;
+	phase p{
+		name,
+		ms(begin - t_start).count(),
+		ms(end - t_start).count(),
+		std::this_thread::get_id() == main_thread
+	};
+
+	std::lock_guard _lk_(phases_mtx);
+	phases_.push_back(p);
+}
+
+void pong::startup::mark(const char* name)
+{
+	auto now = clock::now();
+	record(name, now, now);
+}
+
+auto pong::startup::phases() -> std::vector<phase>
+{
+	std::lock_guard _lk_(phases_mtx);
+	return phases_;
+}
+
+double pong::startup::mark_ms(const char* name)
+{
+	std::lock_guard _lk_(phases_mtx);
+	for (auto& p : phases_) {
+		if (std::strcmp(p.name, name) == 0)
+			return p.end_ms;
+	}
+	return -1;
+}
+
+void pong::startup::print_report(std::FILE* out)
+{
+	fmt::print(out, "startup profile (ms since process start):\n");
+	fmt::print(out, "  {:<28} {:>9} {:>9} {:>9}  {}\n", "phase", "begin", "end", "took", "thread");
+
+	for (auto& p : phases()) {
+		fmt::print(out, "  {:<28} {:>9.2f} {:>9.2f} {:>9.2f}  {}\n",
+			p.name, p.begin_ms, p.end_ms, p.duration(), p.main_thread ? "main" : "worker");
+	}
+}
+
+void pong::startup::write_json(std::FILE* out, double budget_ms)
+{
+	const auto ttff = mark_ms("first_full_frame");
+
+	fmt::print(out, "{{\n  \"phases\": [\n");
+	auto list = phases();
+	for (size_t i = 0; i < list.size(); i++)
+	{
+		auto& p = list[i];
+		fmt::print(out, "    {{\"name\": \"{}\", \"thread\": \"{}\", \"begin_ms\": {:.3f}, \"end_ms\": {:.3f}, \"ms\": {:.3f}}}{}\n",
+			p.name, p.main_thread ? "main" : "worker", p.begin_ms, p.end_ms, p.duration(),
+			i + 1 < list.size() ? "," : "");
+	}
+	fmt::print(out, "  ],\n");
+	fmt::print(out, "  \"time_to_first_frame_ms\": {:.3f},\n", ttff);
+	fmt::print(out, "  \"budget_ms\": {:.3f},\n", budget_ms);
+	fmt::print(out, "  \"within_budget\": {}\n}}\n", budget_ms <= 0 || (ttff >= 0 && ttff <= budget_ms));
+}
@@ -0,0 +1,63 @@
+#pragma once
+#include <chrono>
+#include <string>
+#include <vector>
+#include <cstdio>
+
+// marcos de tempo do startup
+namespace pong::startup
+{
+	using clock = std::chrono::steady_clock;
+
+	// instante aproximado do início do processo (inicialização estática)
+	clock::time_point process_start() noexcept;
+
+	// ms desde process_start()
+	double elapsed_ms() noexcept;
+	double elapsed_ms(clock::time_point since) noexcept;
+
+	// etapa medida, em ms desde process_start()
+	struct phase
+	{
+		const char* name;
+		double begin_ms, end_ms;
+		bool main_thread;
+
+		double duration() const noexcept { return end_ms - begin_ms; }
+	};
+
+	// registra uma etapa, thread-safe
+	void record(const char* name, clock::time_point begin, clock::time_point end);
+	// registra um marco (etapa de duração zero)
+	void mark(const char* name);
+
+	std::vector<phase> phases();
+	// fim do marco `name`, ou < 0 se não existe
+	double mark_ms(const char* name);
+
+	void print_report(std::FILE* out);
+	void write_json(std::FILE* out, double budget_ms);
+
+	// mede o escopo atual
+	class scoped_phase
+	{
+	public:
+		explicit scoped_phase(const char* name_) noexcept
+			: name(name_), begin(clock::now()) {}
+		~scoped_phase() { record(name, begin, clock::now()); }
+
+		scoped_phase(const scoped_phase&) = delete;
+
+	private:
+		const char* name;
+		clock::time_point begin;
+	};
+
+	// mede uma expressão, útil em listas de inicialização
+	template<class Fn>
+	auto timed(const char* name, Fn&& fn)
+	{
+		scoped_phase _p_(name);
+		return fn();
+	}
+}
@@ -0,0 +1,248 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <numeric>
+#include <sstream>
+#include <thread>
+#include <fmt/format.h>
+#include "sweep.h"
+
+bool pong::parse_sweep_axis(std::string_view text, sweep_axis& out)
+{
+	const auto eq = text.find('=');
+	if (eq == text.npos)
+		return false;
+
+	out.key = std::string(text.substr(0, eq));
+	out.field = physics_profile::field(out.key);
+	if (!out.field)
+		return false;
+
+	// "min:max:passos" ou só "valor"
+	std::string range(text.substr(eq + 1));
+	std::replace(range.begin(), range.end(), ':', ' ');
+	std::istringstream in(range);
+	if (!(in >> out.min))
+		return false;
+	if (in >> out.max)
+	{
+		if (!(in >> out.steps))
+			out.steps = 2;
+	}
+	else
+	{
+		out.max = out.min;
+		out.steps = 1;
+	}
+	return out.max >= out.min && out.steps >= 1 && (in >> std::ws).eof();
+}
+
+std::vector<pong::physics_profile> pong::sweep_points(const sweep_config& cfg)
+{
+	auto& axes = cfg.axes;
+
+	if (cfg.latin > 0)
+	{
+		// cada eixo dividido em latin faixas, cada faixa usada uma vez só:
+		// cobre o intervalo inteiro de cada parâmetro com poucos pontos
+		const int n = cfg.latin;
+		std::vector<physics_profile> out(n, cfg.base.guts);
+		std::vector<int> strata(n);
+
+		for (std::size_t a = 0; a < axes.size(); a++)
+		{
+			rng_stream dice(squares::key(cfg.base.seed + 1 + a), 0);
+			std::iota(strata.begin(), strata.end(), 0);
+			for (int i = n - 1; i > 0; i--) {
+				std::swap(strata[i], strata[dice.range(0, i)]);
+			}
+			for (int i = 0; i < n; i++)
+			{
+				const float u = (strata[i] + dice.unit()) / n;
+				out[i].*axes[a].field = axes[a].min + (axes[a].max - axes[a].min) * u;
+			}
+		}
+		return out;
+	}
+
+	// grade: o primeiro eixo varia mais devagar, a tabela sai ordenada por ele
+	std::size_t total = 1;
+	for (auto& a : axes) {
+		total *= std::size_t(a.steps);
+	}
+
+	std::vector<physics_profile> out(total, cfg.base.guts);
+	for (std::size_t i = 0; i < total; i++)
+	{
+		auto rest = i;
+		for (auto a = axes.rbegin(); a != axes.rend(); ++a)
+		{
+			const auto k = int(rest % a->steps);
+			rest /= a->steps;
+			out[i].*a->field = a->steps > 1 ? a->min + (a->max - a->min) * k / (a->steps - 1) : a->min;
+		}
+	}
+	return out;
+}
+
+void pong::sweep_stats::add(const match_outcome& m, int pointsToWin) noexcept
+{
+	matches++;
+	ticks += m.ticks;
+	hits += m.hits;
+	points[0] += m.score[0];
+	points[1] += m.score[1];
+	if (m.score[0] >= pointsToWin) wins[0]++;
+	else if (m.score[1] >= pointsToWin) wins[1]++;
+	else capped++;
+}
+
+void pong::sweep_stats::add_rally(int n) noexcept
+{
+	rallies++;
+	rallySum += n;
+	rallyMax = std::max(rallyMax, n);
+	rallyHist[std::clamp(n, 0, rally_bins - 1)]++;
+}
+
+void pong::sweep_stats::merge(const sweep_stats& o) noexcept
+{
+	matches += o.matches;
+	capped += o.capped;
+	ticks += o.ticks;
+	hits += o.hits;
+	for (int p = 0; p < 2; p++) {
+		points[p] += o.points[p];
+		wins[p] += o.wins[p];
+	}
+	rallies += o.rallies;
+	rallySum += o.rallySum;
+	rallyMax = std::max(rallyMax, o.rallyMax);
+	for (int i = 0; i < rally_bins; i++) {
+		rallyHist[i] += o.rallyHist[i];
+	}
+}
+
+int pong::sweep_stats::rally_percentile(double p) const noexcept
+{
+	// mesmo critério do print_batch: o elemento p * n da lista ordenada
+	const auto rank = std::min(rallies - 1, std::uint64_t(p * rallies));
+	std::uint64_t seen = 0;
+	for (int i = 0; i < rally_bins; i++)
+	{
+		seen += rallyHist[i];
+		if (seen > rank)
+			return i;
+	}
+	return 0;
+}
+
+pong::sweep_result pong::run_sweep(const sweep_config& cfg, columnar::writer* results)
+{
+	sweep_result r;
+	r.points = sweep_points(cfg);
+	r.stats.resize(r.points.size());
+
+	// trabalho em pedaços de partidas de um ponto só: cada thread junta
+	// num sweep_stats local e só trava pra somar no ponto no fim do pedaço
+	const int perPoint = std::max(cfg.base.matches, 1);
+	const int chunk = std::min(perPoint, 32);
+	const std::int64_t chunksPerPoint = (perPoint + chunk - 1) / chunk;
+	const std::int64_t jobs = std::int64_t(r.points.size()) * chunksPerPoint;
+
+	const int threads = int(std::clamp<std::int64_t>(
+		cfg.base.threads > 0 ? cfg.base.threads : int(std::thread::hardware_concurrency()), 1, std::max<std::int64_t>(jobs, 1)));
+	r.threads = threads;
+
+	const auto court = batch_court(cfg.base);
+	std::mutex statsLock;
+	std::atomic<std::int64_t> next{ 0 };
+
+	const auto start = std::chrono::steady_clock::now();
+	{
+		std::vector<std::jthread> workers;
+		for (int t = 0; t < threads; t++)
+		{
+			workers.emplace_back([&] {
+				// um match, uma lista de pontos e um appender por thread,
+				// reaproveitados em todas as partidas: nada é alocado depois daqui
+				match sim(court);
+				std::vector<point_record> scored;
+				scored.reserve(2 * std::size_t(std::max(cfg.base.points, 1)));
+				columnar::writer::appender rows;
+				if (results) rows = results->make_appender();
+				batch_config point = cfg.base;
+
+				for (std::int64_t j; (j = next.fetch_add(1, std::memory_order_relaxed)) < jobs;)
+				{
+					const auto p = std::size_t(j / chunksPerPoint);
+					const int first = int(j % chunksPerPoint) * chunk;
+					const int last = std::min(first + chunk, perPoint);
+					point.guts = r.points[p];
+
+					sweep_stats local;
+					for (int i = first; i < last; i++)
+					{
+						scored.clear();
+						local.add(play_match(sim, point, i, scored), cfg.base.points);
+						for (auto& s : scored) local.add_rally(s.rally);
+						append_points(rows, std::uint32_t(p), i, scored);
+					}
+
+					std::scoped_lock _lock_(statsLock);
+					r.stats[p].merge(local);
+				}
+			});
+		}
+	}
+	r.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	return r;
+}
+
+void pong::write_sweep(std::FILE* out, const sweep_config& cfg, const sweep_result& r, bool csv)
+{
+	if (csv)
+	{
+		for (auto& a : cfg.axes) fmt::print(out, "{},", a.key);
+		fmt::print(out, "matches,wins_p1,wins_p2,capped,points_p1,points_p2,hits,ticks,rally_mean,rally_p50,rally_p90,rally_max\n");
+
+		for (std::size_t i = 0; i < r.points.size(); i++)
+		{
+			auto& s = r.stats[i];
+			for (auto& a : cfg.axes) fmt::print(out, "{},", r.points[i].*a.field);
+			fmt::print(out, "{},{},{},{},{},{},{},{},{:.3f},{},{},{}\n",
+				s.matches, s.wins[0], s.wins[1], s.capped, s.points[0], s.points[1], s.hits, s.ticks,
+				s.rallies ? double(s.rallySum) / s.rallies : 0., s.rally_percentile(.5), s.rally_percentile(.9), s.rallyMax);
+		}
+		return;
+	}
+
+	std::uint64_t ticks = 0;
+	for (auto& s : r.stats) ticks += s.ticks;
+	const auto rate = r.seconds > 0 ? ticks / r.seconds : 0;
+
+	fmt::print(out, "sfPong sweep: {} points x {} matches, {}, seed {}, first to {}, {} threads\n",
+		r.points.size(), cfg.base.matches, gamemode_name(cfg.base.mode), cfg.base.seed, cfg.base.points, r.threads);
+	fmt::print(out, "  ticks: {} in {:.3f} s = {:.2f} M ticks/s\n\n", ticks, r.seconds, rate / 1e6);
+
+	std::vector<int> widths;
+	for (auto& a : cfg.axes)
+	{
+		widths.push_back(int(std::max<std::size_t>(a.key.size(), 8)));
+		fmt::print(out, "{:>{}} ", a.key, widths.back());
+	}
+	fmt::print(out, "{:>7} {:>7} {:>6} {:>6} {:>5} {:>5} {:>7}\n", "P1 win%", "capped", "rally", "p50", "p90", "max", "match s");
+
+	for (std::size_t i = 0; i < r.points.size(); i++)
+	{
+		auto& s = r.stats[i];
+		for (std::size_t a = 0; a < cfg.axes.size(); a++) {
+			fmt::print(out, "{:>{}.3f} ", r.points[i].*cfg.axes[a].field, widths[a]);
+		}
+		const double n = std::max<std::uint64_t>(s.matches, 1);
+		fmt::print(out, "{:>7.1f} {:>7} {:>6.1f} {:>6} {:>5} {:>5} {:>7.1f}\n",
+			100 * s.wins[0] / n, s.capped, s.rallies ? double(s.rallySum) / s.rallies : 0.,
+			s.rally_percentile(.5), s.rally_percentile(.9), s.rallyMax, s.ticks / n / gvar::tick_rate);
+	}
+}
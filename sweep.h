@@ -0,0 +1,69 @@
+#pragma once
+// varredura dos parâmetros da física: --sweep chave=min:max:passos.
+// Os eixos viram uma grade (ou um hipercubo latino com --latin N) e cada
+// ponto roda --simulate partidas sem janela, em todas as threads. Os pontos
+// usam as mesmas seeds: a diferença entre eles é só a física
+#include <array>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "batch.h"
+
+namespace pong
+{
+	struct sweep_axis
+	{
+		std::string key; // como em default-guts.info: "ball.max_speed"
+		float physics_profile::* field = nullptr;
+		float min = 0, max = 0;
+		int steps = 1; // só na grade
+	};
+
+	// "ball.max_speed=10:30:5", ou "ball.max_speed=20" pra um valor só
+	bool parse_sweep_axis(std::string_view text, sweep_axis& out);
+
+	struct sweep_config
+	{
+		batch_config base; // base.matches: partidas por ponto; base.guts: o resto da física
+		std::vector<sweep_axis> axes;
+		int latin = 0; // > 0: tantos pontos num hipercubo latino, em vez da grade
+	};
+
+	// base.guts com os valores dos eixos, na ordem da tabela
+	std::vector<physics_profile> sweep_points(const sweep_config& cfg);
+
+	// resultado de um ponto; só somas, máximo e histograma: não depende da
+	// ordem das partidas nem do número de threads
+	struct sweep_stats
+	{
+		static constexpr int rally_bins = 256; // o último junta 255 ou mais
+
+		std::uint64_t matches = 0, capped = 0;
+		std::uint64_t ticks = 0, hits = 0;
+		std::uint64_t points[2] = {}, wins[2] = {};
+		std::uint64_t rallies = 0, rallySum = 0;
+		int rallyMax = 0;
+		std::array<std::uint64_t, rally_bins> rallyHist = {};
+
+		void add(const match_outcome& m, int pointsToWin) noexcept;
+		void add_rally(int hits) noexcept;
+		void merge(const sweep_stats& other) noexcept;
+
+		int rally_percentile(double p) const noexcept;
+	};
+
+	struct sweep_result
+	{
+		std::vector<physics_profile> points;
+		std::vector<sweep_stats> stats; // um por ponto
+		double seconds = 0;
+		int threads = 0;
+	};
+
+	// results: --results aberto, ou nullptr
+	sweep_result run_sweep(const sweep_config& cfg, columnar::writer* results = nullptr);
+	// uma linha por ponto: tabela alinhada ou CSV
+	void write_sweep(std::FILE* out, const sweep_config& cfg, const sweep_result& r, bool csv);
+}
@@ -0,0 +1,304 @@
+#include "telemetry.h"
+#include "mpmc_queue.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <thread>
+#include <fmt/format.h>
+#include <spdlog/spdlog.h>
+
+namespace fs = std::filesystem;
+using namespace std::literals;
+using namespace pong::telemetry;
+
+namespace
+{
+	constexpr char magic[4] = { 'S', 'F', 'P', 'T' };
+	constexpr std::uint32_t format_version = 1;
+
+	constexpr std::size_t block_events = 256;
+	constexpr std::size_t block_count = 64;
+	constexpr std::uint32_t max_files = 8;
+	constexpr std::size_t max_file_size = 16u << 20;
+
+	struct block
+	{
+		std::uint32_t count;
+		event events[block_events];
+	};
+
+	struct file_header
+	{
+		char magic[4];
+		std::uint32_t version;
+		std::uint64_t session;
+		std::uint32_t seq;
+		std::uint32_t event_size;
+	};
+
+	// alocados no 1o start() e nunca liberados: blocos podem
+	// continuar presos em threads que ainda não terminaram
+	using queue_t = util::mpmc_queue<block*, 128>;
+	static_assert(queue_t::capacity() >= block_count);
+
+	std::unique_ptr<block[]> blocks;
+	std::unique_ptr<queue_t> freeBlocks, fullBlocks;
+
+	std::atomic<bool> running{ false };
+	std::atomic<std::uint64_t> dropped_{ 0 };
+	std::chrono::steady_clock::time_point t0;
+	std::thread writer;
+
+	// estado da thread de escrita
+	struct
+	{
+		fs::path dir;
+		std::uint64_t session = 0;
+		std::uint32_t seq = 0;
+		std::FILE* file = nullptr;
+		std::size_t written = 0;
+	} out;
+
+	struct thread_buffer
+	{
+		block* current = nullptr;
+
+		~thread_buffer() { flush(); }
+	};
+	thread_local thread_buffer tls;
+
+	std::uint32_t now_ms() noexcept
+	{
+		return std::uint32_t(std::chrono::duration_cast<std::chrono::milliseconds>(
+			std::chrono::steady_clock::now() - t0).count());
+	}
+
+	bool open_next_file()
+	{
+		if (out.file) {
+			std::fclose(out.file);
+			out.seq++;
+		}
+
+		auto path = out.dir / fmt::format("telemetry-{}.tlm", out.seq % max_files);
+		out.file = std::fopen(path.string().c_str(), "wb");
+		out.written = 0;
+		if (!out.file) {
+			spdlog::error("telemetry: failed to open {}", path.string());
+			return false;
+		}
+
+		file_header hdr;
+		std::memcpy(hdr.magic, magic, sizeof(magic));
+		hdr.version = format_version;
+		hdr.session = out.session;
+		hdr.seq = out.seq;
+		hdr.event_size = sizeof(event);
+		std::fwrite(&hdr, sizeof(hdr), 1, out.file);
+		return true;
+	}
+
+	void write_block(block* b)
+	{
+		if (out.file)
+		{
+			std::fwrite(b->events, sizeof(event), b->count, out.file);
+			out.written += b->count * sizeof(event);
+
+			if (out.written >= max_file_size)
+				open_next_file();
+		}
+
+		b->count = 0;
+		freeBlocks->push(b);
+	}
+
+	void writer_loop()
+	{
+		block* b;
+		for (;;)
+		{
+			bool any = false;
+			while (fullBlocks->pop(b)) {
+				write_block(b);
+				any = true;
+			}
+
+			// pro disco logo: um crash não leva o buffer do stdio junto
+			if (any && out.file) {
+				std::fflush(out.file);
+			}
+
+			if (!any)
+			{
+				if (!running.load(std::memory_order_acquire))
+					break;
+				std::this_thread::sleep_for(5ms);
+			}
+		}
+
+		if (out.file) {
+			std::fclose(out.file);
+			out.file = nullptr;
+		}
+	}
+}
+
+bool pong::telemetry::start(const fs::path& dir)
+{
+	if (running)
+		return true;
+
+	std::error_code ec;
+	fs::create_directories(dir, ec);
+
+	if (!blocks)
+	{
+		blocks = std::make_unique<block[]>(block_count);
+		freeBlocks = std::make_unique<queue_t>();
+		fullBlocks = std::make_unique<queue_t>();
+
+		for (std::size_t i = 0; i < block_count; i++) {
+			blocks[i].count = 0;
+			freeBlocks->push(&blocks[i]);
+		}
+	}
+	else
+	{
+		// sobra de uma sessão anterior
+		block* b;
+		while (fullBlocks->pop(b)) {
+			b->count = 0;
+			freeBlocks->push(b);
+		}
+	}
+
+	out.dir = dir;
+	out.session = std::chrono::duration_cast<std::chrono::nanoseconds>(
+		std::chrono::system_clock::now().time_since_epoch()).count();
+	out.seq = 0;
+	out.file = nullptr;
+	if (!open_next_file())
+		return false;
+
+	t0 = std::chrono::steady_clock::now();
+	running.store(true, std::memory_order_release); // publica t0
+	writer = std::thread(writer_loop);
+
+	spdlog::info("telemetry: writing to {}", dir.string());
+	return true;
+}
+
+void pong::telemetry::stop()
+{
+	if (!running)
+		return;
+
+	flush();
+	running = false;
+	writer.join();
+
+	if (auto n = dropped()) {
+		spdlog::warn("telemetry: {} events dropped", n);
+	}
+}
+
+bool pong::telemetry::enabled() noexcept
+{
+	return running.load(std::memory_order_relaxed);
+}
+
+void pong::telemetry::emit(event_type type, std::uint8_t player, std::uint16_t data,
+	float f0, float f1, float f2, float f3) noexcept
+{
+	// acquire: t0 é escrito antes de running = true
+	if (!running.load(std::memory_order_acquire))
+		return;
+
+	auto& b = tls.current;
+	if (!b && !freeBlocks->pop(b)) {
+		dropped_.fetch_add(1, std::memory_order_relaxed);
+		return;
+	}
+
+	b->events[b->count++] = { now_ms(), type, player, data, { f0, f1, f2, f3 } };
+
+	if (b->count == block_events) {
+		fullBlocks->push(b);
+		b = nullptr;
+	}
+}
+
+void pong::telemetry::flush() noexcept
+{
+	auto& b = tls.current;
+	if (!b)
+		return;
+
+	if (b->count == 0 || !running.load(std::memory_order_relaxed)) {
+		b->count = 0;
+		freeBlocks->push(b);
+	}
+	else fullBlocks->push(b);
+
+	b = nullptr;
+}
+
+void pong::telemetry::tick() noexcept
+{
+	// running não é lido: bloco só existe com a telemetria ligada, e
+	// flush() devolve pra lista livre se ela parou no meio
+	const auto* b = tls.current;
+	if (b && b->count > 0 && now_ms() - b->events[0].time_ms >= flush_interval_ms) {
+		flush();
+	}
+}
+
+std::uint64_t pong::telemetry::dropped() noexcept
+{
+	return dropped_.load(std::memory_order_relaxed);
+}
+
+bool pong::telemetry::read_file(const fs::path& file, file_info& info,
+	const std::function<void(const event&)>& fn)
+{
+	std::unique_ptr<std::FILE, int(*)(std::FILE*)> in(std::fopen(file.string().c_str(), "rb"), &std::fclose);
+	if (!in)
+		return false;
+
+	file_header hdr;
+	if (std::fread(&hdr, sizeof(hdr), 1, in.get()) != 1
+		|| std::memcmp(hdr.magic, magic, sizeof(magic)) != 0
+		|| hdr.version != format_version
+		|| hdr.event_size != sizeof(event))
+	{
+		return false;
+	}
+
+	info = { hdr.session, hdr.seq };
+
+	event ev;
+	while (std::fread(&ev, sizeof(ev), 1, in.get()) == 1) {
+		fn(ev);
+	}
+
+	return true;
+}
+
+const char* pong::telemetry::to_string(event_type type) noexcept
+{
+	switch (type)
+	{
+	case event_type::serve: return "serve";
+	case event_type::paddle_hit: return "paddle_hit";
+	case event_type::wall_bounce: return "wall_bounce";
+	case event_type::point: return "point";
+	case event_type::pause: return "pause";
+	case event_type::resume: return "resume";
+	case event_type::mode_change: return "mode_change";
+	default: return "???";
+	}
+}
@@ -0,0 +1,67 @@
+#pragma once
+// eventos de partida em binário compacto, pra análise offline
+// (ver tools/telemetry_report.cpp).
+//
+// cada thread junta eventos num bloco próprio; blocos cheios, ou com
+// eventos há mais de flush_interval no fim de um tick, vão por uma fila
+// sem locks pra thread de escrita, que roda os arquivos por tamanho.
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <type_traits>
+
+namespace pong::telemetry
+{
+	enum class event_type : std::uint8_t
+	{
+		serve,       // player = lado do saque, f = { vx, vy }
+		paddle_hit,  // player, f = { offset do impacto [-1,1], vx, vy }
+		wall_bounce, // f = { x, y, vx, vy }
+		point,       // player = quem pontuou, data = rally, f = { placar p1, placar p2 }
+		pause,
+		resume,
+		mode_change, // data = gamemode
+
+		count
+	};
+
+	struct event
+	{
+		std::uint32_t time_ms; // desde start()
+		event_type type;
+		std::uint8_t player;
+		std::uint16_t data;
+		float f[4];
+	};
+	static_assert(sizeof(event) == 24 && std::is_trivially_copyable_v<event>);
+
+	// dir: rotação entre `max_files` arquivos de até `max_file_size` bytes
+	bool start(const std::filesystem::path& dir);
+	void stop();
+	bool enabled() noexcept;
+
+	void emit(event_type type, std::uint8_t player = 0, std::uint16_t data = 0,
+		float f0 = 0, float f1 = 0, float f2 = 0, float f3 = 0) noexcept;
+
+	// manda o bloco da thread atual pra escrita
+	void flush() noexcept;
+
+	// fim de um tick/frame: flush() se o evento mais velho do bloco da
+	// thread passou de flush_interval. Sem bloco é só um teste
+	constexpr std::uint32_t flush_interval_ms = 250;
+	void tick() noexcept;
+
+	// eventos perdidos sem bloco livre
+	std::uint64_t dropped() noexcept;
+
+	// leitura offline; arquivos fora de ordem são aceitos, `seq` ordena
+	struct file_info
+	{
+		std::uint64_t session; // start() que gerou o arquivo
+		std::uint32_t seq;     // ordem do arquivo na sessão
+	};
+	bool read_file(const std::filesystem::path& file, file_info& info,
+		const std::function<void(const event&)>& fn);
+
+	const char* to_string(event_type type) noexcept;
+}
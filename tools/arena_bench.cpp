@@ -0,0 +1,105 @@
+// custo das colisões com a arena por número de obstáculos
+//   sfpong-arena-bench [ticks]
+// obstáculos espalhados no meio da quadra; mede a consulta na BVH contra um
+// laço por todos os retângulos, e um tick inteiro da partida (IA x IA)
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <memory>
+#include <fmt/format.h>
+
+#include "../arena.h"
+#include "../gvar.h"
+#include "../match.h"
+
+using namespace pong;
+
+namespace
+{
+	using clock = std::chrono::steady_clock;
+
+	double ns_since(clock::time_point start) noexcept
+	{
+		return std::chrono::duration<double, std::nano>(clock::now() - start).count();
+	}
+
+	std::shared_ptr<arena> scatter(std::size_t n, std::uint64_t seed)
+	{
+		auto a = std::make_shared<arena>(*arena::standard({ gvar::playarea_width, gvar::playarea_height }));
+		rng_stream dice(squares::key(seed), 0);
+
+		// longe das raquetes e do centro, onde a bola recomeça
+		const float x0 = 150, x1 = gvar::playarea_width - 150;
+		const float y0 = a->top.top + a->top.height + 10, y1 = a->bottom.top - 10;
+		while (a->obstacles.size() < n)
+		{
+			const float w = 8 + 24 * dice.unit(), h = 8 + 24 * dice.unit();
+			const rect r = { x0 + (x1 - x0 - w) * dice.unit(), y0 + (y1 - y0 - h) * dice.unit(), w, h };
+			if (!collision(r, { gvar::playarea_width / 2 - 60, gvar::playarea_height / 2 - 60, 120, 120 })) {
+				a->obstacles.push_back(r);
+			}
+		}
+		a->compile();
+		return a;
+	}
+}
+
+int main(int argc, const char* argv[])
+{
+	const int ticks = argc > 1 ? std::max(1, std::atoi(argv[1])) : 20000;
+	constexpr int queries = 200000;
+
+	fmt::print("{:>9} {:>6} {:>6} {:>12} {:>12} {:>11} {:>8}\n",
+		"obstacles", "nodes", "depth", "bvh ns/q", "linear ns/q", "tick us", "bounces");
+
+	for (std::size_t n : { 0, 10, 100, 250, 500, 1000, 5000 })
+	{
+		auto map = scatter(n, 42);
+
+		// caixas do tamanho da bola em posições sorteadas
+		rng_stream dice(squares::key(7), 0);
+		std::vector<rect> probes(1024);
+		for (auto& p : probes) {
+			p = { gvar::playarea_width * dice.unit(), gvar::playarea_height * dice.unit(), 40, 40 };
+		}
+
+		std::size_t hitsBvh = 0, hitsLinear = 0;
+		auto start = clock::now();
+		for (int q = 0; q < queries; q++) {
+			map->solids.query(probes[q & 1023], [&](const rect&) { hitsBvh++; });
+		}
+		const double bvhNs = ns_since(start) / queries;
+
+		const auto all = map->solids.rects();
+		start = clock::now();
+		for (int q = 0; q < queries; q++) {
+			for (auto& r : all) hitsLinear += collision(r, probes[q & 1023]);
+		}
+		const double linearNs = ns_since(start) / queries;
+
+		if (hitsBvh != hitsLinear) {
+			fmt::print(stderr, "mismatch: bvh {} vs linear {}\n", hitsBvh, hitsLinear);
+			return 1;
+		}
+
+		match sim(court_t::from(map));
+		sim.mute(true);
+		sim.apply({ sim_message::mode, std::uint8_t(gamemode::aitest) });
+		sim.apply({ sim_message::resume });
+
+		std::size_t bounces = 0;
+		start = clock::now();
+		for (int t = 0; t < ticks; t++)
+		{
+			if (sim.waiting_to_serve()) {
+				sim.apply({ sim_message::serve });
+			}
+			sim.step();
+			for (auto& ev : sim.events()) bounces += ev.kind == phys_event::wall_bounce;
+		}
+		const double tickUs = ns_since(start) / ticks / 1000;
+
+		fmt::print("{:>9} {:>6} {:>6} {:>12.1f} {:>12.1f} {:>11.3f} {:>8}\n",
+			n, map->solids.node_count(), map->solids.depth(), bvhNs, linearNs, tickUs, bounces);
+	}
+}
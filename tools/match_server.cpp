@@ -0,0 +1,496 @@
+// servidor de partidas headless: milhares de salas, autoritativo.
+//   sfpong-server --port 7200 --threads 4
+//
+// cada shard é uma thread com seu socket UDP (porta base + índice) e um
+// epoll esperando o socket e um timerfd no ritmo do tick. Uma sala é só um
+// game_state + endereços (poucas centenas de bytes); o shard tem um único
+// match e a cada tick faz restore -> step -> save em cada sala.
+// Só Linux (epoll, timerfd, recvmmsg/sendmmsg).
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+#include <lyra/lyra.hpp>
+#include <spdlog/spdlog.h>
+
+#include "../gvar.h"
+#include "../match.h"
+#include "../ring_buffer.h"
+#include "room_proto.h"
+
+using namespace std::literals;
+using namespace pong;
+namespace proto = pong::room_proto;
+
+namespace
+{
+	using clock = std::chrono::steady_clock;
+
+	constexpr auto player_timeout = 10s;
+	constexpr int batch = 256; // recvmmsg/sendmmsg
+
+	std::atomic<bool> quit{ false };
+
+	struct server_config
+	{
+		unsigned short port = 7200;
+		int threads = int(std::max(1u, std::thread::hardware_concurrency()));
+		int maxRooms = 20000; // total, dividido entre os shards
+		int reportSecs = 5;
+	};
+
+	struct room
+	{
+		game_state state;
+		sockaddr_in peer[2];
+		std::uint32_t echo[2]; // último clientTime de cada jogador
+		clock::time_point lastSeen[2];
+		std::uint32_t id;
+		bool joined[2];
+	};
+
+	bool same_addr(const sockaddr_in& a, const sockaddr_in& b)
+	{
+		return a.sin_addr.s_addr == b.sin_addr.s_addr && a.sin_port == b.sin_port;
+	}
+
+	// duração em microssegundos, percentis no relatório. Só as últimas
+	// window amostras, num buffer fixo por shard: o tick não aloca
+	class latency_log
+	{
+	public:
+		static constexpr std::size_t window = 4096; // ~68 s a 60 Hz
+
+		void add(float us) noexcept { samples.push(us); }
+
+		float percentile(float p) noexcept
+		{
+			if (samples.empty())
+				return 0;
+			// nth_element reordena: numa cópia, que o buffer continua circular
+			const auto n = samples.size();
+			std::copy_n(samples.data(), n, scratch.begin());
+			auto nth = scratch.begin() + std::min(n - 1, std::size_t(p * n));
+			std::nth_element(scratch.begin(), nth, scratch.begin() + n);
+			return *nth;
+		}
+
+		void clear() noexcept { samples.clear(); }
+
+	private:
+		util::ring_buffer<float, window> samples;
+		std::array<float, window> scratch;
+	};
+
+	class shard
+	{
+	public:
+		shard(int index, const server_config& cfg)
+			: index(index), cfg(cfg), sim(court_t::standard({ gvar::playarea_width, gvar::playarea_height }))
+		{
+			maxRooms = std::max(1, cfg.maxRooms / cfg.threads);
+			rooms.reserve(maxRooms);
+			byId.reserve(maxRooms);
+
+			// molde das salas novas: as duas raquetes na IA até alguém entrar
+			sim.mute(true);
+			sim.apply({ sim_message::mode, std::uint8_t(gamemode::aitest) });
+			sim.apply({ sim_message::resume });
+			sim.save(blank);
+		}
+
+		~shard()
+		{
+			if (timer >= 0) close(timer);
+			if (sock >= 0) close(sock);
+			if (epfd >= 0) close(epfd);
+		}
+
+		bool open()
+		{
+			sock = socket(AF_INET, SOCK_DGRAM | SOCK_NONBLOCK, 0);
+			sockaddr_in addr{};
+			addr.sin_family = AF_INET;
+			addr.sin_addr.s_addr = htonl(INADDR_ANY);
+			addr.sin_port = htons(port());
+
+			int size = 4 << 20;
+			setsockopt(sock, SOL_SOCKET, SO_RCVBUF, &size, sizeof(size));
+			setsockopt(sock, SOL_SOCKET, SO_SNDBUF, &size, sizeof(size));
+
+			if (sock < 0 || bind(sock, (sockaddr*)&addr, sizeof(addr)) != 0) {
+				spdlog::error("shard {}: failed to bind udp port {}: {}", index, port(), std::strerror(errno));
+				return false;
+			}
+
+			timer = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK);
+			const long period = 1'000'000'000L / gvar::tick_rate;
+			itimerspec spec{ { 0, period }, { 0, period } };
+			timerfd_settime(timer, 0, &spec, nullptr);
+
+			epfd = epoll_create1(0);
+			epoll_event ev{};
+			ev.events = EPOLLIN;
+			ev.data.fd = sock;
+			epoll_ctl(epfd, EPOLL_CTL_ADD, sock, &ev);
+			ev.data.fd = timer;
+			epoll_ctl(epfd, EPOLL_CTL_ADD, timer, &ev);
+			return true;
+		}
+
+		void run(std::stop_token stop)
+		{
+			epoll_event events[2];
+			auto lastReport = clock::now();
+
+			while (!stop.stop_requested())
+			{
+				const int n = epoll_wait(epfd, events, 2, 100);
+				for (int i = 0; i < n; i++)
+				{
+					if (events[i].data.fd == sock) {
+						receive();
+					}
+					else
+					{
+						std::uint64_t expirations = 0;
+						if (read(timer, &expirations, sizeof(expirations)) != sizeof(expirations))
+							continue;
+
+						// atrasou mais que um tick: recupera até 5, o resto é perdido
+						const auto start = clock::now();
+						const auto steps = std::min<std::uint64_t>(expirations, 5);
+						overruns += expirations - 1;
+						for (std::uint64_t s = 0; s < steps; s++) {
+							tick();
+						}
+						work.add(std::chrono::duration<float, std::micro>(clock::now() - start).count());
+					}
+				}
+
+				if (clock::now() - lastReport > cfg.reportSecs * 1s) {
+					lastReport = clock::now();
+					report();
+				}
+			}
+		}
+
+		unsigned short port() const { return std::uint16_t(cfg.port + index); }
+
+	private:
+		int index;
+		const server_config& cfg;
+		int sock = -1, timer = -1, epfd = -1;
+
+		match sim;
+		game_state blank;
+		std::vector<room> rooms;
+		std::unordered_map<std::uint32_t, std::uint32_t> byId; // id -> índice em rooms
+		int maxRooms;
+
+		// envios do tick, mandados em lote
+		std::uint8_t outBufs[batch][proto::max_packet];
+		std::size_t outSizes[batch];
+		sockaddr_in outAddrs[batch];
+		int outCount = 0;
+		std::uint8_t inBufs[batch][proto::max_packet];
+
+		latency_log work;
+		std::uint64_t ticks = 0, overruns = 0, packetsIn = 0, packetsOut = 0;
+
+		void queue_send(const sockaddr_in& to, const void* data, std::size_t size)
+		{
+			std::memcpy(outBufs[outCount], data, size);
+			outAddrs[outCount] = to;
+			outSizes[outCount] = size;
+			if (++outCount == batch) {
+				flush();
+			}
+		}
+
+		void flush()
+		{
+			mmsghdr msgs[batch];
+			iovec iov[batch];
+			for (int i = 0; i < outCount; i++)
+			{
+				iov[i] = { outBufs[i], outSizes[i] };
+				msgs[i] = {};
+				msgs[i].msg_hdr.msg_name = &outAddrs[i];
+				msgs[i].msg_hdr.msg_namelen = sizeof(sockaddr_in);
+				msgs[i].msg_hdr.msg_iov = &iov[i];
+				msgs[i].msg_hdr.msg_iovlen = 1;
+			}
+
+			// buffer cheio: o resto do lote é perdido, como qualquer pacote UDP
+			int sent = 0;
+			while (sent < outCount)
+			{
+				const int r = sendmmsg(sock, msgs + sent, outCount - sent, 0);
+				if (r <= 0)
+					break;
+				sent += r;
+			}
+			packetsOut += sent;
+			outCount = 0;
+		}
+
+		// extra: slot no welcome, porta no redirect
+		void reply(const sockaddr_in& to, proto::type_t type, std::uint32_t room, unsigned extra = 0)
+		{
+			std::uint8_t buf[16];
+			util::wire_writer w(buf, sizeof(buf));
+			w.put(proto::magic).put(std::uint8_t(type)).put(room);
+			if (type == proto::welcome)
+				w.put(std::uint8_t(extra));
+			else if (type == proto::redirect)
+				w.put(std::uint16_t(extra));
+			queue_send(to, buf, w.size());
+		}
+
+		void receive()
+		{
+			mmsghdr msgs[batch];
+			iovec iov[batch];
+			sockaddr_in from[batch];
+
+			for (;;)
+			{
+				for (int i = 0; i < batch; i++)
+				{
+					iov[i] = { inBufs[i], proto::max_packet };
+					msgs[i] = {};
+					msgs[i].msg_hdr.msg_name = &from[i];
+					msgs[i].msg_hdr.msg_namelen = sizeof(sockaddr_in);
+					msgs[i].msg_hdr.msg_iov = &iov[i];
+					msgs[i].msg_hdr.msg_iovlen = 1;
+				}
+
+				const int n = recvmmsg(sock, msgs, batch, 0, nullptr);
+				if (n <= 0)
+					break;
+
+				packetsIn += n;
+				for (int i = 0; i < n; i++) {
+					handle(from[i], inBufs[i], msgs[i].msg_len);
+				}
+				if (n < batch)
+					break;
+			}
+			flush();
+		}
+
+		void handle(const sockaddr_in& from, const std::uint8_t* data, std::size_t size)
+		{
+			util::wire_reader r(data, size);
+			if (r.get<std::uint32_t>() != proto::magic)
+				return;
+
+			const auto type = r.get<std::uint8_t>();
+			const auto id = r.get<std::uint32_t>();
+			if (!r.ok() || id == 0)
+				return;
+
+			if (int(id % cfg.threads) != index) {
+				if (type == proto::join)
+					reply(from, proto::redirect, id, cfg.port + id % cfg.threads);
+				return;
+			}
+
+			auto it = byId.find(id);
+			if (type == proto::join)
+			{
+				if (it == byId.end())
+				{
+					if (int(rooms.size()) >= maxRooms) {
+						reply(from, proto::full, id);
+						return;
+					}
+					it = byId.emplace(id, std::uint32_t(rooms.size())).first;
+					auto& fresh = rooms.emplace_back(); // zerada
+					fresh.state = blank;
+					fresh.state.rng = squares::key(id);
+					fresh.id = id;
+				}
+
+				auto& rm = rooms[it->second];
+				int slot = -1;
+				for (int s = 0; s < 2 && slot < 0; s++) {
+					if (rm.joined[s] && same_addr(rm.peer[s], from)) slot = s; // join repetido
+				}
+				for (int s = 0; s < 2 && slot < 0; s++) {
+					if (!rm.joined[s]) slot = s;
+				}
+				if (slot < 0) {
+					reply(from, proto::full, id);
+					return;
+				}
+
+				rm.joined[slot] = true;
+				rm.peer[slot] = from;
+				rm.lastSeen[slot] = clock::now();
+				rm.state.paddles[slot].ai = false;
+				reply(from, proto::welcome, id, unsigned(slot));
+				return;
+			}
+
+			if (it == byId.end())
+				return;
+
+			auto& rm = rooms[it->second];
+			const auto slot = r.get<std::uint8_t>();
+			if (slot > 1 || !rm.joined[slot] || !same_addr(rm.peer[slot], from))
+				return;
+
+			if (type == proto::input)
+			{
+				const auto clientTime = r.get<std::uint32_t>();
+				const auto in = proto::get_input(r);
+				if (!r.ok())
+					return;
+
+				rm.state.input.players[slot] = in;
+				rm.echo[slot] = clientTime;
+				rm.lastSeen[slot] = clock::now();
+			}
+			else if (type == proto::leave) {
+				drop(rm, slot);
+			}
+		}
+
+		void drop(room& rm, int slot)
+		{
+			rm.joined[slot] = false;
+			rm.state.paddles[slot].ai = true;
+			rm.state.input.players[slot] = {};
+		}
+
+		void tick()
+		{
+			const auto now = clock::now();
+			ticks++;
+
+			for (std::size_t i = 0; i < rooms.size();)
+			{
+				auto& rm = rooms[i];
+				for (int s = 0; s < 2; s++) {
+					if (rm.joined[s] && now - rm.lastSeen[s] > player_timeout) drop(rm, s);
+				}
+
+				// sala vazia: troca com a última
+				if (!rm.joined[0] && !rm.joined[1])
+				{
+					byId.erase(rm.id);
+					if (i + 1 != rooms.size()) {
+						rm = rooms.back();
+						byId[rm.id] = std::uint32_t(i);
+					}
+					rooms.pop_back();
+					continue;
+				}
+
+				sim.restore(rm.state);
+				if (sim.waiting_to_serve()) {
+					sim.apply({ sim_message::serve });
+				}
+				sim.step();
+				sim.save(rm.state);
+
+				const auto f = sim.frame();
+				proto::state_msg msg;
+				msg.room = rm.id;
+				msg.tick = std::uint32_t(f.tick);
+				msg.p1y = std::int16_t(f.pos[0].y);
+				msg.p2y = std::int16_t(f.pos[1].y);
+				msg.bx = std::int16_t(f.ballPos.x);
+				msg.by = std::int16_t(f.ballPos.y);
+				msg.score1 = std::uint8_t(f.score.first);
+				msg.score2 = std::uint8_t(f.score.second);
+
+				std::uint8_t buf[proto::max_packet];
+				for (int s = 0; s < 2; s++)
+				{
+					if (!rm.joined[s])
+						continue;
+					msg.echoTime = rm.echo[s];
+					queue_send(rm.peer[s], buf, proto::put_state(buf, sizeof(buf), msg));
+				}
+				i++;
+			}
+			flush();
+		}
+
+		void report()
+		{
+			spdlog::info("shard {}: {} rooms, tick p50 {:.0f} us, p99 {:.0f} us, p99.9 {:.0f} us, "
+				"{} overruns, {} in / {} out",
+				index, rooms.size(), work.percentile(.5f), work.percentile(.99f), work.percentile(.999f),
+				overruns, packetsIn, packetsOut);
+			work.clear();
+		}
+	};
+}
+
+int main(int argc, const char* argv[])
+{
+	server_config cfg;
+	bool help = false;
+
+	auto cli = lyra::cli()
+		| lyra::help(help).description("sfPong match server")
+		| lyra::opt(cfg.port, "port")["--port"]("porta UDP base; o shard i usa port + i.")
+		| lyra::opt(cfg.threads, "n")["--threads"]("shards (threads de simulação).")
+		| lyra::opt(cfg.maxRooms, "n")["--max-rooms"]("limite de salas, somando os shards.")
+		| lyra::opt(cfg.reportSecs, "s")["--report"]("intervalo entre os relatórios de cada shard.");
+
+	if (auto result = cli.parse({ argc, argv }); !result) {
+		spdlog::error("{}", result.message());
+		return 1;
+	}
+	if (help) {
+		std::cout << cli << '\n';
+		return 0;
+	}
+	cfg.threads = std::max(cfg.threads, 1);
+
+	std::signal(SIGINT, [](int) { quit = true; });
+	std::signal(SIGTERM, [](int) { quit = true; });
+
+	std::vector<std::unique_ptr<shard>> shards;
+	for (int i = 0; i < cfg.threads; i++)
+	{
+		shards.push_back(std::make_unique<shard>(i, cfg));
+		if (!shards.back()->open())
+			return 1;
+	}
+
+	spdlog::info("sfpong-server: {} shards on udp {}-{}, {} Hz, up to {} rooms ({} bytes each)",
+		cfg.threads, cfg.port, cfg.port + cfg.threads - 1, gvar::tick_rate, cfg.maxRooms, sizeof(room));
+
+	{
+		std::vector<std::jthread> workers;
+		for (auto& s : shards) {
+			workers.emplace_back([&s](std::stop_token stop) { s->run(stop); });
+		}
+
+		while (!quit) {
+			std::this_thread::sleep_for(100ms);
+		}
+	}
+
+	spdlog::info("sfpong-server: bye");
+	return 0;
+}
@@ -0,0 +1,51 @@
+// custo do modo multibola por número de bolas
+//   sfpong-multiball-bench [ticks]
+#include <algorithm>
+#include <cstdlib>
+#include <fmt/format.h>
+
+#include "../gvar.h"
+#include "../multiball.h"
+
+using namespace pong;
+
+int main(int argc, const char* argv[])
+{
+	const int ticks = argc > 1 ? std::max(1, std::atoi(argv[1])) : 600;
+	const auto court = court_t::standard({ gvar::playarea_width, gvar::playarea_height });
+	const rect area = { court.top.left, court.topInner(), court.top.width, court.bottomInner() - court.topInner() };
+
+	// raquetes paradas no meio, como no começo da partida
+	const float py = gvar::playarea_height / 2 - gvar::paddle_height / 2;
+	const rect p1 = { 50, py, gvar::paddle_width, gvar::paddle_height };
+	const rect p2 = { gvar::playarea_width - 50 - gvar::paddle_width, py, gvar::paddle_width, gvar::paddle_height };
+
+	fmt::print("{:>6} {:>6} {:>10} {:>10} {:>10} {:>10} {:>9} {:>9}\n",
+		"balls", "radius", "integr us", "broad us", "narrow us", "total us", "pairs", "contacts");
+
+	for (std::size_t n : { 100, 250, 500, 1000, 2000, 5000, 10000, 20000 })
+	{
+		ball_field field(court, area, n, ball_field::radius_for(area, n), 42);
+		field.spawn(n);
+
+		// assenta antes de medir: as bolas nascem sobrepostas
+		for (int t = 0; t < 60; t++) field.step(p1, p2);
+
+		multiball_stats sum;
+		for (int t = 0; t < ticks; t++)
+		{
+			field.step(p1, p2);
+			auto& s = field.stats();
+			sum.integrateUs += s.integrateUs;
+			sum.broadphaseUs += s.broadphaseUs;
+			sum.narrowphaseUs += s.narrowphaseUs;
+			sum.pairs += s.pairs;
+			sum.contacts += s.contacts;
+		}
+
+		const auto total = sum.integrateUs + sum.broadphaseUs + sum.narrowphaseUs;
+		fmt::print("{:>6} {:>6.1f} {:>10.1f} {:>10.1f} {:>10.1f} {:>10.1f} {:>9} {:>9}\n",
+			n, field.radius(), sum.integrateUs / ticks, sum.broadphaseUs / ticks, sum.narrowphaseUs / ticks,
+			total / ticks, sum.pairs / ticks, sum.contacts / ticks);
+	}
+}
@@ -0,0 +1,137 @@
+// lê um arquivo colunar do sfPong (--simulate ... --results arquivo)
+//   sfpong-results <arquivo> [coluna_grupo coluna_valor]
+// sem grupo: resumo de cada coluna só pelo rodapé, e uma leitura completa
+// cronometrada. Com grupo: contagem, média e máximo do valor por grupo
+// (ex. "sweep_point rally", "scorer rally")
+#include <algorithm>
+#include <chrono>
+#include <limits>
+#include <vector>
+#include <fmt/format.h>
+
+#include "../columnar.h"
+
+using namespace pong::columnar;
+
+namespace
+{
+	using clock = std::chrono::steady_clock;
+
+	const char* type_name(column_type t) noexcept
+	{
+		switch (t)
+		{
+		case column_type::i32: return "i32";
+		case column_type::u32: return "u32";
+		case column_type::u64: return "u64";
+		case column_type::f32: return "f32";
+		case column_type::f64: return "f64";
+		default: return "???";
+		}
+	}
+
+	// f(T{}) com o tipo da coluna
+	template<class F>
+	void with_type(column_type t, F&& f)
+	{
+		switch (t)
+		{
+		case column_type::i32: f(std::int32_t{}); break;
+		case column_type::u32: f(std::uint32_t{}); break;
+		case column_type::u64: f(std::uint64_t{}); break;
+		case column_type::f32: f(float{}); break;
+		case column_type::f64: f(double{}); break;
+		}
+	}
+
+	struct group_acc
+	{
+		std::uint64_t count = 0;
+		double sum = 0, max = -std::numeric_limits<double>::infinity();
+	};
+}
+
+int main(int argc, const char* argv[])
+{
+	if (argc != 2 && argc != 4) {
+		fmt::print(stderr, "uso: {} <arquivo> [coluna_grupo coluna_valor]\n", argv[0]);
+		return 1;
+	}
+
+	reader in;
+	if (!in.open(argv[1])) {
+		fmt::print(stderr, "{}: não abriu\n", argv[1]);
+		return 1;
+	}
+
+	const auto cols = in.columns();
+	fmt::print("{}: {} rows, {} groups, {:.1f} MB\n", argv[1], in.rows(), in.groups(), in.file_size() / 1e6);
+
+	if (argc == 2)
+	{
+		fmt::print("\n{:<14} {:>4} {:>14} {:>14} {:>14}\n", "column", "type", "min", "max", "mean");
+		for (std::size_t c = 0; c < cols.size(); c++)
+		{
+			const auto s = in.stats(c);
+			fmt::print("{:<14} {:>4} {:>14.6g} {:>14.6g} {:>14.6g}\n", cols[c].name, type_name(cols[c].type),
+				s.min, s.max, s.count ? s.sum / s.count : 0.);
+		}
+
+		// todas as colunas, uma de cada vez
+		double check = 0;
+		const auto start = clock::now();
+		for (std::size_t c = 0; c < cols.size(); c++)
+		{
+			with_type(cols[c].type, [&](auto zero) {
+				in.scan<decltype(zero)>(c, [&](auto values) {
+					for (auto v : values) check += double(v);
+				});
+			});
+		}
+		const double secs = std::chrono::duration<double>(clock::now() - start).count();
+		fmt::print("\nfull scan: {:.3f} s, {:.1f} M values/s (checksum {:.6g})\n",
+			secs, secs > 0 ? in.rows() * cols.size() / secs / 1e6 : 0., check);
+		return 0;
+	}
+
+	const int group = in.find(argv[2]), value = in.find(argv[3]);
+	if (group < 0 || value < 0 || group == value) {
+		fmt::print(stderr, "colunas: grupo e valor precisam existir e ser diferentes\n");
+		return 1;
+	}
+	if (cols[group].type != column_type::u32) {
+		fmt::print(stderr, "a coluna do grupo precisa ser u32\n");
+		return 1;
+	}
+
+	// o rodapé dá o maior grupo: vetor direto em vez de mapa
+	const auto groupMax = in.stats(group).max;
+	if (groupMax >= 1 << 24) {
+		fmt::print(stderr, "grupos demais ({})\n", groupMax);
+		return 1;
+	}
+	std::vector<group_acc> acc(in.rows() ? std::size_t(groupMax) + 1 : 0);
+
+	const auto start = clock::now();
+	with_type(cols[value].type, [&](auto zero) {
+		in.scan<std::uint32_t, decltype(zero)>(group, value, [&](auto keys, auto values) {
+			for (std::size_t i = 0; i < keys.size(); i++)
+			{
+				auto& a = acc[keys[i]];
+				a.count++;
+				a.sum += double(values[i]);
+				a.max = std::max(a.max, double(values[i]));
+			}
+		});
+	});
+	const double secs = std::chrono::duration<double>(clock::now() - start).count();
+
+	fmt::print("\n{:>12} {:>12} {:>12} {:>12}\n", argv[2], "count", fmt::format("{} mean", argv[3]), "max");
+	for (std::size_t g = 0; g < acc.size(); g++)
+	{
+		if (acc[g].count) {
+			fmt::print("{:>12} {:>12} {:>12.3f} {:>12.6g}\n", g, acc[g].count, acc[g].sum / acc[g].count, acc[g].max);
+		}
+	}
+	fmt::print("\n{:.3f} s, {:.1f} M rows/s\n", secs, secs > 0 ? in.rows() / secs / 1e6 : 0.);
+}
@@ -0,0 +1,75 @@
+#pragma once
+// protocolo entre sfpong-server e os clientes (sfpong-bot).
+//
+// o cliente manda join pra porta base; se a sala é de outro shard a
+// resposta é redirect com a porta certa. Depois disso só input (cliente)
+// e state (servidor), um por tick. O servidor ecoa o último clientTime
+// recebido daquele jogador, o bastante pro cliente medir a latência.
+#include <cstdint>
+#include "../wire.h"
+#include "../match.h"
+
+namespace pong::room_proto
+{
+	constexpr std::uint32_t magic = 0x53504653; // "SFPS"
+	constexpr int max_packet = 64;
+
+	enum type_t : std::uint8_t { join, welcome, redirect, full, input, state, leave };
+
+	// join: room. welcome: room, slot. redirect: room, port. full: room
+	// leave: room, slot
+	// input: room, slot, clientTime, bits, axis
+	// state: room, tick, echoTime, p1y, p2y, bx, by (px), score1, score2
+
+	enum input_bits : std::uint8_t { bit_up = 1, bit_down = 2, bit_fast = 4, bit_joystick = 8 };
+
+	inline void put_input(util::wire_writer& w, const player_input& in)
+	{
+		std::uint8_t bits = (in.up ? bit_up : 0) | (in.down ? bit_down : 0) | (in.fast ? bit_fast : 0)
+			| (in.joystick ? bit_joystick : 0);
+		w.put(bits).put(in.axis);
+	}
+
+	inline player_input get_input(util::wire_reader& r)
+	{
+		player_input in;
+		const auto bits = r.get<std::uint8_t>();
+		in.axis = r.get<float>();
+		in.up = bits & bit_up;
+		in.down = bits & bit_down;
+		in.fast = bits & bit_fast;
+		in.joystick = bits & bit_joystick;
+		return in;
+	}
+
+	struct state_msg
+	{
+		std::uint32_t room = 0, tick = 0, echoTime = 0;
+		std::int16_t p1y = 0, p2y = 0, bx = 0, by = 0;
+		std::uint8_t score1 = 0, score2 = 0;
+	};
+
+	inline std::size_t put_state(void* buf, std::size_t cap, const state_msg& s)
+	{
+		util::wire_writer w(buf, cap);
+		w.put(magic).put(std::uint8_t(state)).put(s.room).put(s.tick).put(s.echoTime)
+			.put(s.p1y).put(s.p2y).put(s.bx).put(s.by).put(s.score1).put(s.score2);
+		return w.ok() ? w.size() : 0;
+	}
+
+	// depois de magic, type e room já lidos
+	inline state_msg get_state(util::wire_reader& r, std::uint32_t room)
+	{
+		state_msg s;
+		s.room = room;
+		s.tick = r.get<std::uint32_t>();
+		s.echoTime = r.get<std::uint32_t>();
+		s.p1y = r.get<std::int16_t>();
+		s.p2y = r.get<std::int16_t>();
+		s.bx = r.get<std::int16_t>();
+		s.by = r.get<std::int16_t>();
+		s.score1 = r.get<std::uint8_t>();
+		s.score2 = r.get<std::uint8_t>();
+		return s;
+	}
+}
@@ -0,0 +1,265 @@
+// gerador de carga pro sfpong-server: N salas com 1 ou 2 bots cada.
+//   sfpong-bot --host 127.0.0.1 --port 7200 --rooms 2000 --players 2 --seconds 30
+//
+// cada bot manda input a cada tick seguindo a bola do último estado.
+// No fim imprime a latência input -> estado (o servidor ecoa o clientTime)
+// em percentis, quantas salas entraram e a perda de estados.
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <vector>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+#include <fmt/format.h>
+#include <lyra/lyra.hpp>
+
+#include "../gvar.h"
+#include "room_proto.h"
+
+using namespace std::literals;
+using namespace pong;
+namespace proto = pong::room_proto;
+
+namespace
+{
+	using clock = std::chrono::steady_clock;
+
+	struct bot
+	{
+		std::uint32_t room = 0;
+		int sock = 0;              // índice em sockets
+		unsigned short port = 0;   // do shard da sala
+		int slot = -1;             // -1 = ainda não entrou
+		std::uint32_t lastTick = 0, states = 0, gaps = 0;
+		float paddleY = 0, ballY = 0;
+		clock::time_point lastJoin;
+	};
+
+	clock::time_point epoch = clock::now();
+
+	std::uint32_t now_us()
+	{
+		return std::uint32_t((clock::now() - epoch) / 1us) + 1;
+	}
+}
+
+int main(int argc, const char* argv[])
+{
+	std::string host = "127.0.0.1";
+	unsigned short port = 7200;
+	int rooms = 100, players = 2, seconds = 10, sockets = 64;
+	bool help = false;
+
+	auto cli = lyra::cli()
+		| lyra::help(help).description("sfPong server load generator")
+		| lyra::opt(host, "host")["--host"]("endereço do servidor.")
+		| lyra::opt(port, "port")["--port"]("porta base do servidor.")
+		| lyra::opt(rooms, "n")["--rooms"]("salas a abrir.")
+		| lyra::opt(players, "1|2")["--players"]("bots por sala.")
+		| lyra::opt(seconds, "s")["--seconds"]("duração da carga.")
+		| lyra::opt(sockets, "n")["--sockets"]("sockets UDP locais, os bots se dividem entre eles.");
+
+	if (auto result = cli.parse({ argc, argv }); !result) {
+		fmt::print(stderr, "{}\n", result.message());
+		return 1;
+	}
+	if (help) {
+		std::cout << cli << '\n';
+		return 0;
+	}
+	players = std::clamp(players, 1, 2);
+	sockets = std::max(sockets, 2);
+
+	sockaddr_in server{};
+	server.sin_family = AF_INET;
+	if (inet_pton(AF_INET, host.c_str(), &server.sin_addr) != 1) {
+		fmt::print(stderr, "endereço inválido: {}\n", host);
+		return 1;
+	}
+
+	const int epfd = epoll_create1(0);
+	std::vector<int> fds(sockets);
+	for (int i = 0; i < sockets; i++)
+	{
+		fds[i] = socket(AF_INET, SOCK_DGRAM | SOCK_NONBLOCK, 0);
+		int size = 4 << 20;
+		setsockopt(fds[i], SOL_SOCKET, SO_RCVBUF, &size, sizeof(size));
+
+		epoll_event ev{};
+		ev.events = EPOLLIN;
+		ev.data.u32 = std::uint32_t(i);
+		epoll_ctl(epfd, EPOLL_CTL_ADD, fds[i], &ev);
+	}
+
+	const int timer = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK);
+	const long period = 1'000'000'000L / gvar::tick_rate;
+	itimerspec spec{ { 0, period }, { 0, period } };
+	timerfd_settime(timer, 0, &spec, nullptr);
+	epoll_event tev{};
+	tev.events = EPOLLIN;
+	tev.data.u32 = UINT32_MAX;
+	epoll_ctl(epfd, EPOLL_CTL_ADD, timer, &tev);
+
+	// os dois bots de uma sala ficam em sockets diferentes: o servidor
+	// distingue os jogadores pelo endereço
+	std::vector<bot> bots(std::size_t(rooms) * players);
+	for (std::size_t i = 0; i < bots.size(); i++)
+	{
+		bots[i].room = std::uint32_t(i / players + 1);
+		bots[i].sock = int(i % sockets);
+		bots[i].port = port;
+	}
+
+	auto send_to = [&](const bot& b, const void* data, std::size_t size) {
+		sockaddr_in to = server;
+		to.sin_port = htons(b.port);
+		sendto(fds[b.sock], data, size, 0, (sockaddr*)&to, sizeof(to));
+	};
+
+	auto find = [&](std::uint32_t room, int sock) -> bot* {
+		const auto first = std::size_t(room - 1) * players;
+		for (std::size_t i = first; i < first + players && i < bots.size(); i++) {
+			if (bots[i].sock == sock) return &bots[i];
+		}
+		return nullptr;
+	};
+
+	std::vector<float> rtt;
+	rtt.reserve(std::size_t(seconds) * gvar::tick_rate * bots.size());
+	std::uint64_t full = 0;
+	const auto end = clock::now() + seconds * 1s;
+	std::uint8_t buf[proto::max_packet];
+
+	while (clock::now() < end)
+	{
+		epoll_event events[64];
+		const int n = epoll_wait(epfd, events, 64, 100);
+
+		for (int e = 0; e < n; e++)
+		{
+			if (events[e].data.u32 == UINT32_MAX)
+			{
+				std::uint64_t expirations;
+				if (read(timer, &expirations, sizeof(expirations)) != sizeof(expirations))
+					continue;
+
+				const auto now = clock::now();
+				for (auto& b : bots)
+				{
+					util::wire_writer w(buf, sizeof(buf));
+					if (b.slot < 0)
+					{
+						if (now - b.lastJoin < 500ms)
+							continue;
+						b.lastJoin = now;
+						w.put(proto::magic).put(std::uint8_t(proto::join)).put(b.room);
+					}
+					else
+					{
+						// segue a bola, com uma folga pra não tremer
+						player_input in;
+						in.up = b.ballY < b.paddleY - 20;
+						in.down = b.ballY > b.paddleY + 20;
+						w.put(proto::magic).put(std::uint8_t(proto::input)).put(b.room)
+							.put(std::uint8_t(b.slot)).put(now_us());
+						proto::put_input(w, in);
+					}
+					send_to(b, buf, w.size());
+				}
+				continue;
+			}
+
+			const int s = int(events[e].data.u32);
+			sockaddr_in from{};
+			socklen_t fromLen = sizeof(from);
+			ssize_t size;
+			while ((size = recvfrom(fds[s], buf, sizeof(buf), 0, (sockaddr*)&from, &fromLen)) > 0)
+			{
+				util::wire_reader r(buf, std::size_t(size));
+				if (r.get<std::uint32_t>() != proto::magic)
+					continue;
+
+				const auto type = r.get<std::uint8_t>();
+				const auto room = r.get<std::uint32_t>();
+				auto* b = find(room, s);
+				if (!b)
+					continue;
+
+				if (type == proto::redirect)
+				{
+					// sala de outro shard: entra de novo na porta certa, no próximo tick
+					b->port = r.get<std::uint16_t>();
+					b->lastJoin = {};
+				}
+				else if (type == proto::welcome)
+				{
+					b->slot = r.get<std::uint8_t>();
+					b->port = ntohs(from.sin_port);
+				}
+				else if (type == proto::full) {
+					full++;
+				}
+				else if (type == proto::state)
+				{
+					const auto st = proto::get_state(r, room);
+					if (!r.ok())
+						continue;
+
+					if (b->states && st.tick > b->lastTick + 1)
+						b->gaps += st.tick - b->lastTick - 1;
+					b->lastTick = std::max(b->lastTick, st.tick);
+					b->states++;
+					b->paddleY = (b->slot == 0 ? st.p1y : st.p2y) + gvar::paddle_height / 2;
+					b->ballY = st.by;
+
+					if (st.echoTime)
+						rtt.push_back((now_us() - st.echoTime) / 1000.f);
+				}
+			}
+		}
+	}
+
+	// avisa o servidor pra liberar as salas
+	for (auto& b : bots)
+	{
+		if (b.slot < 0)
+			continue;
+		util::wire_writer w(buf, sizeof(buf));
+		w.put(proto::magic).put(std::uint8_t(proto::leave)).put(b.room).put(std::uint8_t(b.slot));
+		send_to(b, buf, w.size());
+	}
+
+	std::size_t joined = 0;
+	std::uint64_t states = 0, gaps = 0;
+	for (auto& b : bots)
+	{
+		joined += b.slot >= 0;
+		states += b.states;
+		gaps += b.gaps;
+	}
+
+	auto pct = [&](float p) {
+		if (rtt.empty())
+			return 0.f;
+		auto nth = rtt.begin() + std::min(rtt.size() - 1, std::size_t(p * rtt.size()));
+		std::nth_element(rtt.begin(), nth, rtt.end());
+		return *nth;
+	};
+
+	fmt::print("bots: {}/{} joined ({} rooms, {} full replies)\n", joined, bots.size(), rooms, full);
+	fmt::print("states: {} received, {} missing ({:.2f}%)\n", states, gaps,
+		states + gaps ? 100.0 * gaps / (states + gaps) : 0.0);
+	fmt::print("input -> state latency: p50 {:.2f} ms, p99 {:.2f} ms, p99.9 {:.2f} ms, max {:.2f} ms\n",
+		pct(.5f), pct(.99f), pct(.999f), pct(1));
+
+	for (auto fd : fds) close(fd);
+	close(timer);
+	close(epfd);
+	return 0;
+}
@@ -0,0 +1,124 @@
+// agrega arquivos de telemetria do sfPong
+//   sfpong-telemetry <arquivo.tlm | diretório>...
+#include <algorithm>
+#include <cmath>
+#include <filesystem>
+#include <map>
+#include <tuple>
+#include <vector>
+#include <fmt/format.h>
+
+#include "../telemetry.h"
+
+namespace fs = std::filesystem;
+using namespace pong::telemetry;
+
+namespace
+{
+	struct histogram
+	{
+		float bin;
+		std::map<int, long> counts;
+		long total = 0;
+		double sum = 0;
+		float max = 0;
+
+		void add(float value)
+		{
+			counts[int(std::floor(value / bin))]++;
+			total++;
+			sum += value;
+			max = std::max(max, value);
+		}
+
+		void print(const char* title) const
+		{
+			fmt::print("\n{} (n={}, média={:.2f}, max={:.2f})\n", title, total, total ? sum / total : 0., max);
+
+			long peak = 0;
+			for (auto& [k, n] : counts) peak = std::max(peak, n);
+
+			for (auto& [k, n] : counts)
+			{
+				auto bar = int(40.0 * n / peak);
+				fmt::print("  {:>6.1f} - {:<6.1f} {:>8} {:#<{}}\n", k * bin, (k + 1) * bin, n, "", bar);
+			}
+		}
+	};
+}
+
+int main(int argc, const char* argv[])
+{
+	if (argc < 2) {
+		fmt::print(stderr, "uso: {} <arquivo.tlm | diretório>...\n", argv[0]);
+		return 1;
+	}
+
+	std::vector<fs::path> files;
+	for (int i = 1; i < argc; i++)
+	{
+		fs::path p = argv[i];
+		if (fs::is_directory(p)) {
+			for (auto& entry : fs::directory_iterator(p)) {
+				if (entry.path().extension() == ".tlm")
+					files.push_back(entry.path());
+			}
+		}
+		else files.push_back(p);
+	}
+
+	// ordena por sessão/seq pra ler os eventos na ordem em que foram gravados
+	std::vector<std::tuple<file_info, fs::path>> ordered;
+	for (auto& f : files)
+	{
+		file_info info;
+		if (read_file(f, info, [](const event&) {}))
+			ordered.emplace_back(info, f);
+		else
+			fmt::print(stderr, "ignorando {}: formato inválido\n", f.string());
+	}
+	std::sort(ordered.begin(), ordered.end(), [](auto& a, auto& b) {
+		auto& [ia, pa] = a;
+		auto& [ib, pb] = b;
+		return std::tie(ia.session, ia.seq) < std::tie(ib.session, ib.seq);
+	});
+
+	long counts[size_t(event_type::count)] = {};
+	histogram rallies{ 1 }, hitSpeed{ 2 }, serveSpeed{ 1 };
+
+	for (auto& [info, path] : ordered)
+	{
+		read_file(path, info, [&](const event& ev)
+		{
+			if (ev.type >= event_type::count)
+				return;
+			counts[size_t(ev.type)]++;
+
+			switch (ev.type)
+			{
+			case event_type::point:
+				rallies.add(ev.data);
+				break;
+			case event_type::paddle_hit:
+				hitSpeed.add(std::hypot(ev.f[1], ev.f[2]));
+				break;
+			case event_type::serve:
+				serveSpeed.add(std::hypot(ev.f[0], ev.f[1]));
+				break;
+			default:
+				break;
+			}
+		});
+	}
+
+	fmt::print("{} arquivo(s)\n", ordered.size());
+	for (size_t i = 0; i < size_t(event_type::count); i++) {
+		fmt::print("  {:<12} {:>10}\n", to_string(event_type(i)), counts[i]);
+	}
+
+	rallies.print("Rally (rebatidas por ponto)");
+	hitSpeed.print("Velocidade da bola após rebatida");
+	serveSpeed.print("Velocidade do saque");
+
+	return 0;
+}
@@ -0,0 +1,45 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+namespace util
+{
+    // troca de estado entre um escritor e um leitor sem locks:
+    // o escritor nunca espera e o leitor sempre pega o último publicado
+    template<class T>
+    class triple_buffer
+    {
+    public:
+        triple_buffer() = default;
+        triple_buffer(const triple_buffer&) = delete;
+
+        // escritor: preenche write() e chama publish()
+        T& write() noexcept { return slots[back]; }
+
+        void publish() noexcept
+        {
+            back = middle.exchange(back | fresh, std::memory_order_acq_rel) & index_mask;
+        }
+
+        // leitor: true se trocou pra um estado novo desde a última chamada
+        bool update() noexcept
+        {
+            if (!(middle.load(std::memory_order_relaxed) & fresh))
+                return false;
+
+            front = middle.exchange(front, std::memory_order_acq_rel) & index_mask;
+            return true;
+        }
+
+        const T& read() const noexcept { return slots[front]; }
+
+    private:
+        static constexpr std::uint8_t index_mask = 0b011, fresh = 0b100;
+
+        std::array<T, 3> slots{};
+        alignas(64) std::atomic<std::uint8_t> middle{ 1 };
+        alignas(64) std::uint8_t back = 0;
+        alignas(64) std::uint8_t front = 2;
+    };
+}
@@ -0,0 +1,121 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+namespace util
+{
+    // serialização little-endian pra pacotes de rede, sem alocação.
+    // estourar o buffer não escreve/lê nada e marca ok() = false
+    class wire_writer
+    {
+    public:
+        wire_writer(void* buf, std::size_t cap) noexcept
+            : data(static_cast<std::uint8_t*>(buf)), cap(cap) {}
+
+        template<class T>
+        wire_writer& put(T value) noexcept
+        {
+            static_assert(std::is_arithmetic_v<T>);
+            if (len + sizeof(T) > cap) {
+                good = false;
+                return *this;
+            }
+
+            std::uint8_t bytes[sizeof(T)];
+            std::memcpy(bytes, &value, sizeof(T));
+            for (std::size_t i = 0; i < sizeof(T); i++)
+                data[len + i] = bytes[little_endian() ? i : sizeof(T) - 1 - i];
+
+            len += sizeof(T);
+            return *this;
+        }
+
+        // 7 bits por byte, pequeno ocupa pouco
+        wire_writer& put_varint(std::uint64_t value) noexcept
+        {
+            while (value >= 0x80) {
+                put(std::uint8_t(value | 0x80));
+                value >>= 7;
+            }
+            return put(std::uint8_t(value));
+        }
+
+        // zigzag: -1 -> 1, 1 -> 2...
+        wire_writer& put_svarint(std::int64_t value) noexcept
+        {
+            return put_varint((std::uint64_t(value) << 1) ^ std::uint64_t(value >> 63));
+        }
+
+        std::size_t size() const noexcept { return len; }
+        bool ok() const noexcept { return good; }
+
+    private:
+        std::uint8_t* data;
+        std::size_t cap, len = 0;
+        bool good = true;
+
+        static bool little_endian() noexcept
+        {
+            const std::uint16_t one = 1;
+            return *reinterpret_cast<const std::uint8_t*>(&one) == 1;
+        }
+
+        friend class wire_reader;
+    };
+
+    class wire_reader
+    {
+    public:
+        wire_reader(const void* buf, std::size_t size) noexcept
+            : data(static_cast<const std::uint8_t*>(buf)), len(size) {}
+
+        template<class T>
+        T get() noexcept
+        {
+            static_assert(std::is_arithmetic_v<T>);
+            if (pos + sizeof(T) > len) {
+                good = false;
+                return T{};
+            }
+
+            std::uint8_t bytes[sizeof(T)];
+            for (std::size_t i = 0; i < sizeof(T); i++)
+                bytes[wire_writer::little_endian() ? i : sizeof(T) - 1 - i] = data[pos + i];
+
+            T value;
+            std::memcpy(&value, bytes, sizeof(T));
+            pos += sizeof(T);
+            return value;
+        }
+
+        std::uint64_t get_varint() noexcept
+        {
+            std::uint64_t value = 0;
+            for (int shift = 0; shift < 64; shift += 7)
+            {
+                const auto byte = get<std::uint8_t>();
+                value |= std::uint64_t(byte & 0x7f) << shift;
+                if (!(byte & 0x80))
+                    return value;
+            }
+            good = false;
+            return 0;
+        }
+
+        std::int64_t get_svarint() noexcept
+        {
+            const auto v = get_varint();
+            return std::int64_t(v >> 1) ^ -std::int64_t(v & 1);
+        }
+
+        std::size_t remaining() const noexcept { return good ? len - pos : 0; }
+        bool ok() const noexcept { return good; }
+
+    private:
+        const std::uint8_t* data;
+        std::size_t len, pos = 0;
+        bool good = true;
+    };
+}